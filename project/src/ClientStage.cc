@@ -41,6 +41,8 @@ void ClientStage::scheduleNextRequest(int clientId) {
 // Handler for clientRequest
 void ClientStage::handleClientRequest(PipelineMessage* msg) {
 
+    PROFILE_HANDLER(profiler, "handleClientRequest");
+
     // Debug Logging
     EV_DEBUG << "ClientStage::handleClientRequest called" << endl;
 
@@ -75,4 +77,9 @@ void ClientStage::handleMessage(cMessage* msg) {
         throw cRuntimeError("ClientStage received an unknown message: '%s'", msg->getName());
 }
 
+// Records profiling results, if enabled
+void ClientStage::finish() {
+    PROFILE_RECORD(profiler);
+}
+
 };
@@ -11,6 +11,7 @@
 
 #include <omnetpp.h>
 #include "PipelineMessage_m.h"
+#include "Profiling.h"
 
 
 using namespace omnetpp;
@@ -25,6 +26,7 @@ class ClientStage : public cSimpleModule
   protected:
     virtual void initialize();
     virtual void handleMessage(cMessage *msg);
+    virtual void finish();
     virtual void scheduleNextRequest(int clientId);
     virtual void handleClientRequest(PipelineMessage* msg);
   private:
@@ -34,6 +36,10 @@ class ClientStage : public cSimpleModule
     // Counter of request ID's
     long maxRequestId;
 
+#ifdef PIPELINE_PROFILING
+    HandlerProfiler profiler;
+#endif
+
 
 };
 
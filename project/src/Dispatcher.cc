@@ -0,0 +1,204 @@
+#include "Dispatcher.h"
+#include "FirstStage.h"
+#include <algorithm>
+#include <cmath>
+
+namespace project {
+
+Define_Module(Dispatcher);
+
+
+// Called once at the beginning of the simulation
+void Dispatcher::initialize() {
+
+    // Load parameters from NED file
+    std::string policyName = par("policy").stdstringValue();
+    workStealing = par("workStealing").boolValue();
+
+    if (policyName == "random")
+        policy = RANDOM;
+    else if (policyName == "roundRobin")
+        policy = ROUND_ROBIN;
+    else if (policyName == "jsq")
+        policy = JSQ;
+    else if (policyName == "powerOfTwo")
+        policy = POWER_OF_TWO;
+    else
+        throw cRuntimeError("Dispatcher: unknown dispatch policy '%s'", policyName.c_str());
+
+    // Collect the pools connected to the output gates
+    for (int i = 0; i < gateSize("out"); i++) {
+        cModule* mod = gate("out", i)->getPathEndGate()->getOwnerModule();
+        pools.push_back(check_and_cast<FirstStage*>(mod));
+    }
+    if (pools.empty())
+        throw cRuntimeError("Dispatcher: no FirstStage pool connected");
+
+    dispatchedRequests.assign(pools.size(), 0);
+    nextPool = 0;
+    stolenRequests = 0;
+
+    // Registering Signal
+    dispatchedPool = registerSignal("dispatchedPool");
+    loadImbalance = registerSignal("loadImbalance");
+    emit(loadImbalance, 0);
+}
+
+// Number of requests held by a pool, either in service or queued
+int Dispatcher::getPoolLoad(int poolId) const {
+    return pools[poolId]->getBusyThreads() + pools[poolId]->getQueueLength();
+}
+
+// Chooses the destination pool according to the configured policy
+int Dispatcher::selectPool() {
+
+    int numPools = pools.size();
+
+    switch (policy) {
+
+        case RANDOM:
+            return intuniform(0, numPools - 1);
+
+        case ROUND_ROBIN: {
+            int poolId = nextPool;
+            nextPool = (nextPool + 1) % numPools;
+            return poolId;
+        }
+
+        // Join the shortest queue, ties broken by the lowest pool ID
+        case JSQ: {
+            int best = 0;
+            for (int i = 1; i < numPools; i++)
+                if (getPoolLoad(i) < getPoolLoad(best))
+                    best = i;
+            return best;
+        }
+
+        // Sample two distinct pools and join the less loaded one
+        case POWER_OF_TWO: {
+            if (numPools == 1)
+                return 0;
+            int first = intuniform(0, numPools - 1);
+            int second = intuniform(0, numPools - 2);
+            if (second >= first)
+                second++;
+            return getPoolLoad(second) < getPoolLoad(first) ? second : first;
+        }
+    }
+
+    return 0;
+}
+
+// Main message handler
+void Dispatcher::handleMessage(cMessage* msg) {
+
+    PROFILE_HANDLER(profiler, "handleMessage");
+
+    // Debug Logging
+    EV_DEBUG << "Dispatcher::handleMessage called." << endl;
+
+    // A request has arrived from the clients
+    if (msg->isName("toServe1")) {
+        auto* reqMsg = check_and_cast<PipelineMessage*>(msg);
+
+        int poolId = selectPool();
+        reqMsg->setPoolId(poolId);
+        dispatchedRequests[poolId]++;
+        emit(dispatchedPool, poolId);
+
+        // Imbalance as the spread between the most and the least loaded pool
+        int maxLoad = getPoolLoad(0), minLoad = getPoolLoad(0);
+        for (size_t i = 1; i < pools.size(); i++) {
+            maxLoad = std::max(maxLoad, getPoolLoad(i));
+            minLoad = std::min(minLoad, getPoolLoad(i));
+        }
+        emit(loadImbalance, maxLoad - minLoad);
+
+        EV_INFO << "Request " << reqMsg->getRequestId() << " dispatched to pool " << poolId << endl;
+        send(reqMsg, "out", poolId);
+    }
+
+    // If an unforeseen message arrives throw an error
+    else
+        throw cRuntimeError("Dispatcher received an unknown message: '%s'", msg->getName());
+}
+
+// Moves the oldest queued request of the victim to a free thread of the thief
+void Dispatcher::steal(FirstStage* victim, FirstStage* thief) {
+
+    PipelineMessage* msg = victim->stealRequest();
+    if (!msg)
+        return;
+
+    stolenRequests++;
+    EV_INFO << "Request " << msg->getRequestId() << " stolen by pool " << thief->getIndex()
+            << " from pool " << victim->getIndex() << endl;
+    thief->serveStolen(msg);
+}
+
+// A pool had to queue a request: hand it over to the most idle pool, if any
+void Dispatcher::requestQueued(FirstStage* pool) {
+
+    Enter_Method("requestQueued()");
+
+    if (!workStealing)
+        return;
+
+    FirstStage* thief = nullptr;
+    for (FirstStage* candidate : pools)
+        if (candidate->getAvailableThreads() > 0 && (!thief || candidate->getAvailableThreads() > thief->getAvailableThreads()))
+            thief = candidate;
+
+    if (thief)
+        steal(pool, thief);
+}
+
+// A pool has a free thread and an empty queue: steal from the longest queue
+void Dispatcher::threadReleased(FirstStage* pool) {
+
+    Enter_Method("threadReleased()");
+
+    if (!workStealing)
+        return;
+
+    FirstStage* victim = nullptr;
+    for (FirstStage* candidate : pools)
+        if (candidate->getQueueLength() > 0 && (!victim || candidate->getQueueLength() > victim->getQueueLength()))
+            victim = candidate;
+
+    if (victim)
+        steal(victim, pool);
+}
+
+// Records per-pool utilization and imbalance metrics
+void Dispatcher::finish() {
+
+    int numPools = pools.size();
+    double sumUtil = 0, maxUtil = 0, minUtil = 1;
+    double sumDispatched = 0, sumSqDispatched = 0;
+
+    for (int i = 0; i < numPools; i++) {
+        double util = pools[i]->getUtilization();
+        sumUtil += util;
+        maxUtil = std::max(maxUtil, util);
+        minUtil = std::min(minUtil, util);
+
+        sumDispatched += dispatchedRequests[i];
+        sumSqDispatched += (double)dispatchedRequests[i] * dispatchedRequests[i];
+        recordScalar(("dispatchedRequests:pool" + std::to_string(i)).c_str(), dispatchedRequests[i]);
+    }
+
+    double meanUtil = sumUtil / numPools;
+    double meanDispatched = sumDispatched / numPools;
+    double varDispatched = sumSqDispatched / numPools - meanDispatched * meanDispatched;
+
+    recordScalar("meanUtilization", meanUtil);
+    recordScalar("utilizationSpread", maxUtil - minUtil);
+    recordScalar("utilizationImbalance", meanUtil > 0 ? maxUtil / meanUtil : 0);
+    recordScalar("dispatchCV", meanDispatched > 0 ? std::sqrt(std::max(0.0, varDispatched)) / meanDispatched : 0);
+    recordScalar("stolenRequests", stolenRequests);
+
+    PROFILE_RECORD(profiler);
+}
+
+}; // namespace
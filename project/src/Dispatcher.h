@@ -0,0 +1,69 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef DISPATCHER_H_
+#define DISPATCHER_H_
+
+#include <omnetpp.h>
+#include <vector>
+#include "PipelineMessage_m.h"
+#include "Profiling.h"
+
+using namespace omnetpp;
+
+namespace project {
+
+class FirstStage;
+
+class Dispatcher : public cSimpleModule
+{
+  public:
+    // Work stealing hooks, called by the FirstStage pools
+    virtual void requestQueued(FirstStage* pool);
+    virtual void threadReleased(FirstStage* pool);
+
+  protected:
+    virtual void initialize();
+    virtual void handleMessage(cMessage *msg);
+    virtual void finish();
+    virtual int selectPool();
+    virtual int getPoolLoad(int poolId) const;
+    virtual void steal(FirstStage* victim, FirstStage* thief);
+
+  private:
+    enum Policy { RANDOM, ROUND_ROBIN, JSQ, POWER_OF_TWO };
+
+    // Module parameters
+    Policy policy;
+    bool workStealing;
+
+    // Pools connected to the out[] gates, indexed by pool ID
+    std::vector<FirstStage*> pools;
+    std::vector<long> dispatchedRequests;
+    int nextPool;
+    long stolenRequests;
+
+    // Module statistic signals
+    simsignal_t dispatchedPool;
+    simsignal_t loadImbalance;
+
+#ifdef PIPELINE_PROFILING
+    HandlerProfiler profiler;
+#endif
+};
+
+}; // namespace
+
+#endif
@@ -6,8 +6,8 @@
  */
 
 #include "FirstStage.h"
-#include "RequestMessage_m.h"
-#include "ClientRequestMessage_m.h"
+#include "Dispatcher.h"
+#include "SecondStage.h"
 #include <queue>
 
 namespace project {
@@ -21,11 +21,15 @@ void FirstStage::initialize() {
     // Extracting Parameters from NED file
     numThreads = par("numThreads").intValue();
     meanServiceTime = par("meanServiceTime").doubleValue();
+    maxQueueSize = par("maxQueueSize").intValue();
 
     // Registering Signal
     queueSize = registerSignal("queueSize");
+    busyThreads = registerSignal("busyThreads");
     partialRequestTime = registerSignal("partialRequestTime");
+    responseTime = registerSignal("responseTime");
     emit(queueSize, 0);
+    emit(busyThreads, 0);
 
     // At the beginning every thread is free
     availableThreads = numThreads;
@@ -33,6 +37,48 @@ void FirstStage::initialize() {
         availableThreadIDs.push(i + 1);
     }
 
+    // A Dispatcher in front of the pool is optional: in the plain Pipeline
+    // network requests come straight from the clients
+    cGate* srcGate = gate("in")->getPathStartGate();
+    dispatcher = dynamic_cast<Dispatcher*>(srcGate->getOwnerModule());
+
+    // Utilization bookkeeping
+    busyThreadTime = 0;
+    lastBusyChange = simTime();
+    warmupBusyTime = 0;
+    warmupPassed = false;
+    stolenRequests = 0;
+    queueTime = 0;
+    lastQueueChange = simTime();
+
+    // Optional regenerative estimation: the empty system at time 0 is the
+    // first regeneration point
+    if (par("regenerative").boolValue()) {
+        if (dispatcher)
+            throw cRuntimeError("FirstStage: regenerative estimation needs a single pool, not a Dispatcher");
+        secondStage = check_and_cast<SecondStage*>(gate("out")->getPathEndGate()->getOwnerModule());
+        regenerative = new RegenerativeEstimator(par("regenerativePrecision").doubleValue(),
+                                                 par("regenerativeMinCycles").intValue());
+        startCycle();
+    }
+
+    // Optional request tracing, one trace file per pool
+    if (par("tracing").boolValue()) {
+        std::string fileName = par("traceFile").stdstringValue();
+        if (fileName.empty()) {
+            cConfigurationEx* cfg = getEnvir()->getConfigEx();
+            fileName = std::string(cfg->getVariable("resultdir")) + "/" + cfg->getVariable("configname") + "-"
+                       + cfg->getVariable("runnumber") + "-" + getFullName() + ".trace";
+        }
+        tracer = new RequestTracer(fileName, getIndex(), par("traceBufferSize").intValue(),
+                                   par("traceSamplingRate").doubleValue());
+    }
+
+}
+
+FirstStage::~FirstStage() {
+    delete tracer;
+    delete regenerative;
 }
 
 // Computes a random service delay using a uniform distribution
@@ -44,45 +90,71 @@ simtime_t FirstStage::getServiceDelay(int threadId) const {
     return uniform(0, 2*meanServiceTime, threadId);
 }
 
-// Schedules the completion of the request
-void FirstStage::scheduleRequest(long requestId, int threadId) {
+// Returns the time-averaged fraction of busy threads since the end of the
+// warm-up period, so it covers the same interval as the signal statistics
+double FirstStage::getUtilization() const {
 
-    // Debug Logging
-    EV_DEBUG << "FirstStage::scheduleRequest called. requestId: " << requestId
-             << ", threadId: " << threadId;
+    simtime_t warmup = getSimulation()->getWarmupPeriod();
+    double elapsed = (simTime() - warmup).dbl();
+    if (elapsed <= 0)
+        return 0;
 
-    // Creating and Sending Message
-    auto* endMsg = new RequestMessage("secondStage");
-    endMsg->setRequestId(requestId);
-    endMsg->setThreadId(threadId);
-    simtime_t delay = getServiceDelay(threadId);
-    scheduleAt(simTime() + delay, endMsg);
+    double busyTime = busyThreadTime + (numThreads - availableThreads) * (simTime() - lastBusyChange).dbl();
+    return (busyTime - getWarmupBusyTime()) / (elapsed * numThreads);
+}
 
-    // Logging
-    EV_INFO << "Request " << requestId << " is being served. Delay: " << delay << endl;
+// Returns the busy-thread time integral at the end of the warm-up period,
+// valid once the warm-up period is over
+double FirstStage::getWarmupBusyTime() const {
+
+    if (warmupPassed)
+        return warmupBusyTime;
+
+    // No thread change since the end of the warm-up period yet
+    simtime_t warmup = getSimulation()->getWarmupPeriod();
+    return busyThreadTime + (numThreads - availableThreads) * (warmup - lastBusyChange).dbl();
+}
+
+// Accumulates the busy-thread time integral and updates the busy thread counter
+void FirstStage::updateBusyThreads(int delta) {
+
+    // Freeze the integral at the end of the warm-up period on the first
+    // change after it
+    if (!warmupPassed && simTime() >= getSimulation()->getWarmupPeriod()) {
+        warmupBusyTime = getWarmupBusyTime();
+        warmupPassed = true;
+    }
+
+    busyThreadTime += (numThreads - availableThreads) * (simTime() - lastBusyChange).dbl();
+    lastBusyChange = simTime();
+    availableThreads -= delta;
+    emit(busyThreads, numThreads - availableThreads);
 
 }
 
-// Sends a RequestMessage with a given name and request ID through a specified gate
-void FirstStage::sendRequestMessage(const char* name, long requestId, int threadId, const char* gateName) {
+// Schedules the completion of the request
+void FirstStage::scheduleRequest(PipelineMessage* msg, int threadId) {
 
     // Debug Logging
-    EV_DEBUG << "FirstStage::sendRequestMessage called. name: " << name << ", requestId: " << requestId
-             << ", threadId: " << threadId << ", gateName: " << gateName << endl;
+    EV_DEBUG << "FirstStage::scheduleRequest called. requestId: " << msg->getRequestId()
+             << ", threadId: " << threadId << endl;
 
-    // Creating and Sending Request Message
-    auto* msg = new RequestMessage(name);
-    msg->setRequestId(requestId);
+    // Reusing the same message as completion event
+    msg->setName("secondStage");
     msg->setThreadId(threadId);
-    send(msg, gateName);
+    msg->setStartFirst(simTime());
+    simtime_t delay = getServiceDelay(threadId);
+    scheduleAt(simTime() + delay, msg);
 
-    // Log the sending
-    EV_INFO << "Sent message '" << name << "' to gate '" << gateName;
+    // Logging
+    EV_INFO << "Request " << msg->getRequestId() << " is being served. Delay: " << delay << endl;
 
 }
 
 // Handles a new incoming request from a client
-void FirstStage::handleServe(RequestMessage* msg) {
+void FirstStage::handleServe(PipelineMessage* msg) {
+
+    PROFILE_HANDLER(profiler, "handleServe");
 
     // Debug Logging
     EV_DEBUG << "FirstStage:handleServe called." << endl;
@@ -91,30 +163,45 @@ void FirstStage::handleServe(RequestMessage* msg) {
     long requestId = msg->getRequestId();
     EV_INFO << "Request " << requestId << " arrived." << endl;
 
-    // Stores arrival time of the request in an unordered map (which maps
-    // request ID to arrival times) that will be used to compute partial
-    // request time
-    requestId2arrivalTime[requestId] = simTime();
+    // Stores arrival time of the request inside the message, it will be
+    // used to compute partial and total request time
+    msg->setArrivalFirst(simTime());
 
     // If no thread is available then push into the waiting queue and log
     if (availableThreads == 0) {
-        waitingRequests.push(requestId);
-        emit(queueSize, waitingRequests.size());
+        updateQueueTime();
+        waitingRequests.insert(msg);
+        emit(queueSize, waitingRequests.getLength());
+        PROFILE_QUEUE(profiler, waitingRequests.getLength());
         EV_INFO << "Request " << requestId << " queued due to no available threads." << endl;
+
+        // A runaway queue means the point is saturated: stop the run early
+        if (maxQueueSize >= 0 && waitingRequests.getLength() > maxQueueSize) {
+            EV_WARN << "Queue size exceeded " << maxQueueSize << ", ending the simulation." << endl;
+            endSimulation();
+        }
+
+        // Give idle pools a chance to steal the queued request
+        if (dispatcher)
+            dispatcher->requestQueued(this);
     }
 
     // Otherwise start the execution and schedule the end of a request
     else {
-        availableThreads--;
+        updateBusyThreads(+1);
         int threadId = availableThreadIDs.front();
         availableThreadIDs.pop();
-        scheduleRequest(requestId, threadId);
+        scheduleRequest(msg, threadId);
     }
 
+    PROFILE_INFLIGHT(profiler, getBusyThreads() + getQueueLength());
+
 }
 
 // Handles a request that has completed the first stage
-void FirstStage::handleSecondStage(RequestMessage* msg) {
+void FirstStage::handleSecondStage(PipelineMessage* msg) {
+
+    PROFILE_HANDLER(profiler, "handleSecondStage");
 
     // Debug Logging
     EV_DEBUG << "FirstStage::handleSecondStage called" << endl;
@@ -124,20 +211,20 @@ void FirstStage::handleSecondStage(RequestMessage* msg) {
     int threadId = msg->getThreadId();
     EV_INFO << "Request " << requestId << ", Thread ID: " << threadId << " completed first stage, forwarding to second stage." << endl;
 
-    // Compute Partial Request Time by extracting arrival time from an hash map
-    // write the statistics and remove entry from hash map
-    simtime_t parReqTime = simTime() - requestId2arrivalTime[requestId];
-    requestId2arrivalTime.erase(requestId);
+    // Compute Partial Request Time using the arrival time stored in the message
+    simtime_t parReqTime = simTime() - msg->getArrivalFirst();
     emit(partialRequestTime, parReqTime);
 
-
     // Send Request Message to the next stage
-    sendRequestMessage("secondStage", requestId, threadId, "out");
+    msg->setName("toServe2");
+    send(msg, "out");
 
 }
 
 // Handles a request that has completed all stages
-void FirstStage::handleEnd(RequestMessage* msg) {
+void FirstStage::handleEnd(PipelineMessage* msg) {
+
+    PROFILE_HANDLER(profiler, "handleEnd");
 
     // Debug Logging
     EV_DEBUG << "FirstStage::handleEnd called" << endl;
@@ -147,24 +234,134 @@ void FirstStage::handleEnd(RequestMessage* msg) {
     int threadId = msg->getThreadId();
     EV_INFO << "Request " << requestId << " with Thread: " << threadId << " completed. Thread released." << endl;
 
-    // Sending Request Completion to Client
-    sendRequestMessage("end", requestId, threadId, "endReqOut");
+    // The request leaves the system: record its total response time
+    emit(responseTime, simTime() - msg->getArrivalFirst());
+    if (regenerative) {
+        cycleCompletions++;
+        cycleResponseTime += (simTime() - msg->getArrivalFirst()).dbl();
+    }
+    if (tracer)
+        traceRequest(msg);
+    delete msg;
 
     // If the queue is not empty extract a request and schedule it
-    if (!waitingRequests.empty()) {
-        long nextRequestId = waitingRequests.front();
-        waitingRequests.pop();
-        scheduleRequest(nextRequestId, threadId);
-        EV_INFO << "Request " << nextRequestId << " extracted from queue and being served." << endl;
-        emit(queueSize, waitingRequests.size());
+    if (!waitingRequests.isEmpty()) {
+        updateQueueTime();
+        PipelineMessage* nextMsg = check_and_cast<PipelineMessage*>(waitingRequests.pop());
+        scheduleRequest(nextMsg, threadId);
+        EV_INFO << "Request " << nextMsg->getRequestId() << " extracted from queue and being served." << endl;
+        emit(queueSize, waitingRequests.getLength());
     }
 
     // Otherwise increase the number of available threads
     else {
-        availableThreads++;
+        updateBusyThreads(-1);
         availableThreadIDs.push(threadId);
+
+        // Every thread free: no request left anywhere, a regeneration point
+        if (regenerative && getBusyThreads() == 0 && secondStage->isIdle())
+            regenerationPoint();
+
+        // The released thread may steal a request queued in a busier pool
+        if (dispatcher)
+            dispatcher->threadReleased(this);
+    }
+
+}
+
+// Accumulates the queue length integral, called before every queue change
+void FirstStage::updateQueueTime() {
+    queueTime += waitingRequests.getLength() * (simTime() - lastQueueChange).dbl();
+    lastQueueChange = simTime();
+}
+
+// Starts a regeneration cycle at the current time
+void FirstStage::startCycle() {
+    cycleStart = simTime();
+    cycleCompletions = 0;
+    cycleResponseTime = 0;
+    cycleQueueTime = queueTime;
+    cycleQueueTime2 = secondStage->getQueueTimeIntegral();
+    cycleBusyThreadTime = busyThreadTime;
+}
+
+// Closes the current regeneration cycle, the system has just become empty
+void FirstStage::regenerationPoint() {
+
+    updateQueueTime();
+
+    RegenerationCycle cycle;
+    cycle.length = (simTime() - cycleStart).dbl();
+    cycle.completions = cycleCompletions;
+    cycle.responseTimeSum = cycleResponseTime;
+    cycle.queueTime = queueTime - cycleQueueTime;
+    cycle.queueTime2 = secondStage->getQueueTimeIntegral() - cycleQueueTime2;
+    cycle.busyThreadTime = busyThreadTime - cycleBusyThreadTime;
+    regenerative->addCycle(cycle);
+    startCycle();
+
+    // Stop as soon as the target precision is met
+    if (regenerative->isPrecisionReached()) {
+        EV_INFO << "Target precision reached after " << regenerative->getCycles()
+                << " regeneration cycles, ending the simulation." << endl;
+        endSimulation();
     }
+}
 
+// Stores the stage timeline of a completed request in the trace
+void FirstStage::traceRequest(PipelineMessage* msg) {
+
+    if (!tracer->isSampled(msg->getRequestId()))
+        return;
+
+    TraceRecord rec;
+    rec.requestId = msg->getRequestId();
+    rec.clientId = msg->getClientId();
+    rec.poolId = msg->getPoolId();
+    rec.threadId = msg->getThreadId();
+    rec.arrivalFirst = msg->getArrivalFirst().dbl();
+    rec.startFirst = msg->getStartFirst().dbl();
+    rec.arrivalSecond = msg->getArrivalSecond().dbl();
+    rec.startSecond = msg->getStartSecond().dbl();
+    rec.arrivalThird = msg->getArrivalThird().dbl();
+    rec.completion = simTime().dbl();
+    tracer->record(rec);
+}
+
+// Hands over the oldest queued request, called by the Dispatcher
+PipelineMessage* FirstStage::stealRequest() {
+
+    Enter_Method("stealRequest()");
+
+    if (waitingRequests.isEmpty())
+        return nullptr;
+
+    updateQueueTime();
+    PipelineMessage* msg = check_and_cast<PipelineMessage*>(waitingRequests.pop());
+    emit(queueSize, waitingRequests.getLength());
+    EV_INFO << "Request " << msg->getRequestId() << " handed over to another pool." << endl;
+
+    return msg;
+}
+
+// Starts serving a request stolen from another pool, called by the Dispatcher
+void FirstStage::serveStolen(PipelineMessage* msg) {
+
+    Enter_Method("serveStolen()");
+    take(msg);
+
+    // The Dispatcher only steals on behalf of pools with a free thread
+    if (availableThreads == 0)
+        throw cRuntimeError("FirstStage: stolen request %ld but no thread available", msg->getRequestId());
+
+    msg->setPoolId(getIndex());
+    stolenRequests++;
+    updateBusyThreads(+1);
+    int threadId = availableThreadIDs.front();
+    availableThreadIDs.pop();
+    scheduleRequest(msg, threadId);
+
+    EV_INFO << "Request " << msg->getRequestId() << " stolen from another pool and being served." << endl;
 }
 
 // Main message handler
@@ -173,28 +370,68 @@ void FirstStage::handleMessage(cMessage* msg) {
     // Debug logging
     EV_DEBUG << "FirstStage::handleMessage called." << endl;
 
-    auto* reqMsg = check_and_cast<RequestMessage*>(msg);
+    auto* reqMsg = check_and_cast<PipelineMessage*>(msg);
 
     // A request has arrived from a client
-    if (msg->isName("serve"))
+    if (msg->isName("toServe1"))
         handleServe(reqMsg);
 
     // A request has completed the first stage
     else if (msg->isName("secondStage"))
         handleSecondStage(reqMsg);
 
-    // A completed request has arrived from second stage
-    else if (msg->isName("end"))
+    // A completed request has arrived from third stage
+    else if (msg->isName("processingComplete"))
         handleEnd(reqMsg);
 
     // If an unforeseen message arrives throw an error
     else
         throw cRuntimeError("FirstStage received an unknown message: '%s'", msg->getName());
 
+    // Message ownership is handled inside the handlers
 
-    delete msg;
+}
+
+// Records per-pool statistics at the end of the simulation
+void FirstStage::finish() {
+
+    recordScalar("utilization", getUtilization());
+    recordScalar("stolenRequests", stolenRequests);
+
+    // Requests left in queue per second of simulated time: it stays close
+    // to zero for a stable system and grows with the overload otherwise
+    double elapsed = simTime().dbl();
+    recordScalar("backlogRate", elapsed > 0 ? waitingRequests.getLength() / elapsed : 0);
+
+    // Steady-state means and 95% confidence interval half widths from the
+    // regeneration cycles (the last, incomplete cycle is discarded)
+    if (regenerative) {
+        recordScalar("regenCycles", regenerative->getCycles());
+        recordScalar("regenPrecisionReached", regenerative->isPrecisionReached());
+        recordScalar("regenResponseTime", regenerative->getResponseTime().getEstimate());
+        recordScalar("regenResponseTimeCI", regenerative->getResponseTime().getHalfWidth());
+        recordScalar("regenQueueSize", regenerative->getQueueSize().getEstimate());
+        recordScalar("regenQueueSizeCI", regenerative->getQueueSize().getHalfWidth());
+        recordScalar("regenQueueSize2", regenerative->getQueueSize2().getEstimate());
+        recordScalar("regenQueueSize2CI", regenerative->getQueueSize2().getHalfWidth());
+        recordScalar("regenBusyThreads", regenerative->getBusyThreads().getEstimate());
+        recordScalar("regenBusyThreadsCI", regenerative->getBusyThreads().getHalfWidth());
+        delete regenerative;
+        regenerative = nullptr;
+    }
+
+    // Flush the trace
+    if (tracer) {
+        recordScalar("tracedRequests", tracer->getRecorded());
+        recordScalar("traceDroppedRequests", tracer->getDropped());
+        delete tracer;
+        tracer = nullptr;
+    }
+
+    PROFILE_RECORD(profiler);
 
 }
+
 /*
 void FirstStage::initialize() {
 
@@ -10,36 +10,97 @@
 
 #include <omnetpp.h>
 #include <queue>
-#include "RequestMessage_m.h"
+#include "PipelineMessage_m.h"
+#include "Profiling.h"
+#include "RegenerativeEstimator.h"
+#include "RequestTracer.h"
 
 using namespace omnetpp;
 
 namespace project {
 
+class Dispatcher;
+class SecondStage;
+
 /**
  * Implements the Hub simple module. See the NED file for more information.
  */
 class FirstStage : public cSimpleModule
 {
+  public:
+    // Load information queried by the Dispatcher
+    int getQueueLength() const { return waitingRequests.getLength(); }
+    int getAvailableThreads() const { return availableThreads; }
+    int getBusyThreads() const { return numThreads - availableThreads; }
+    double getUtilization() const;
+
+    // Work stealing between pools, driven by the Dispatcher
+    virtual PipelineMessage* stealRequest();
+    virtual void serveStolen(PipelineMessage* msg);
+
+    virtual ~FirstStage();
+
   protected:
     virtual void initialize();
     virtual void handleMessage(cMessage *msg);
+    virtual void finish();
     virtual simtime_t getServiceDelay(int threadId) const;
-    virtual void scheduleRequest(long requestId, int threadId);
-    virtual void sendRequestMessage(const char* name, long requestId, int threadId, const char* gateName);
-    virtual void handleServe(RequestMessage* msg);
-    virtual void handleSecondStage(RequestMessage* msg);
-    virtual void handleEnd(RequestMessage* msg);
+    virtual void scheduleRequest(PipelineMessage* msg, int threadId);
+    virtual void handleServe(PipelineMessage* msg);
+    virtual void handleSecondStage(PipelineMessage* msg);
+    virtual void handleEnd(PipelineMessage* msg);
+    virtual void updateBusyThreads(int delta);
+    double getWarmupBusyTime() const;
+    virtual void traceRequest(PipelineMessage* msg);
+    virtual void updateQueueTime();
+    virtual void startCycle();
+    virtual void regenerationPoint();
 
   private:
     int numThreads;
     int availableThreads;
     double meanServiceTime;
-    std::queue<long> waitingRequests;
+    int maxQueueSize;
+    cQueue waitingRequests;
     std::queue<int> availableThreadIDs;
-    std::unordered_map<long, simtime_t> requestId2arrivalTime;
+
+    // Dispatcher in front of this pool, if any (used for work stealing)
+    Dispatcher* dispatcher;
+
+    // Time integral of the busy threads, used to compute utilization, and
+    // its value at the end of the warm-up period (excluded from utilization)
+    double busyThreadTime;
+    simtime_t lastBusyChange;
+    double warmupBusyTime;
+    bool warmupPassed;
+    long stolenRequests;
+
+    // Time integral of the queue length
+    double queueTime;
+    simtime_t lastQueueChange;
+
+    // Regenerative estimation, null unless enabled. The cycle fields hold
+    // the sums of the current cycle and the integrals at its start
+    RegenerativeEstimator* regenerative = nullptr;
+    SecondStage* secondStage = nullptr;
+    simtime_t cycleStart;
+    long cycleCompletions;
+    double cycleResponseTime;
+    double cycleQueueTime;
+    double cycleQueueTime2;
+    double cycleBusyThreadTime;
+
+    // Per-request stage timeline recorder, null unless tracing is enabled
+    RequestTracer* tracer = nullptr;
+
+#ifdef PIPELINE_PROFILING
+    HandlerProfiler profiler;
+#endif
+
     simsignal_t queueSize;
+    simsignal_t busyThreads;
     simsignal_t partialRequestTime;
+    simsignal_t responseTime;
 };
 
 }; // namespace
@@ -0,0 +1,60 @@
+#include "Profiling.h"
+
+#ifdef PIPELINE_PROFILING
+
+#include <cstring>
+#include <iostream>
+
+namespace project {
+
+// Handlers are few per module: a linear search is enough
+HandlerStats& HandlerProfiler::getHandler(const char* name) {
+
+    for (HandlerStats& stats : handlers)
+        if (stats.name == name || !std::strcmp(stats.name, name))
+            return stats;
+
+    handlers.push_back(HandlerStats());
+    handlers.back().name = name;
+    return handlers.back();
+}
+
+void HandlerProfiler::sampled(cComponent* owner) {
+
+    peakLiveMessages = std::max(peakLiveMessages, (long)cMessage::getLiveMessageCount());
+
+    Clock::time_point now = Clock::now();
+    if (now - lastReport >= std::chrono::seconds(PIPELINE_PROFILING_INTERVAL)) {
+        lastReport = now;
+        printSummary(owner);
+    }
+}
+
+// Live summary on the console, so it also shows in Cmdenv express mode
+void HandlerProfiler::printSummary(cComponent* owner) {
+
+    std::cout << "[profile] t=" << simTime() << " " << owner->getFullPath() << ":";
+    for (const HandlerStats& stats : handlers)
+        std::cout << " " << stats.name << " " << stats.events << " ev, "
+                  << (stats.samples ? stats.sampledNanos / stats.samples : 0) << " ns/ev;";
+    std::cout << " peak queue " << peakQueue << ", peak in-flight " << peakInFlight
+              << ", peak live msgs " << peakLiveMessages << std::endl;
+}
+
+void HandlerProfiler::recordScalars(cComponent* owner) {
+
+    for (const HandlerStats& stats : handlers) {
+        std::string prefix = std::string("profile:") + stats.name;
+        double meanNanos = stats.samples ? stats.sampledNanos / stats.samples : 0;
+        owner->recordScalar((prefix + ":events").c_str(), stats.events);
+        owner->recordScalar((prefix + ":meanWallTime").c_str(), meanNanos * 1e-9, "s");
+        owner->recordScalar((prefix + ":totalWallTime").c_str(), meanNanos * 1e-9 * stats.events, "s");
+    }
+    owner->recordScalar("profile:peakQueue", peakQueue);
+    owner->recordScalar("profile:peakInFlight", peakInFlight);
+    owner->recordScalar("profile:peakLiveMessages", peakLiveMessages);
+}
+
+}; // namespace
+
+#endif
@@ -0,0 +1,130 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+
+#ifndef PROFILING_H_
+#define PROFILING_H_
+
+//
+// Hot-path profiling of the message handlers, enabled at compile time with
+// -DPIPELINE_PROFILING (e.g. CFLAGS += -DPIPELINE_PROFILING in src/makefrag,
+// or opp_makemake -f --deep -DPIPELINE_PROFILING). When disabled, the
+// PROFILE_* macros expand to nothing and no profiling code is compiled.
+//
+// For every handler it counts the events and samples the wall-clock cost of
+// one event every PIPELINE_PROFILING_SAMPLE (steady_clock). Modules also
+// report peak queue depths, peak in-flight requests and the peak of the
+// process-wide live message count seen at their sampled events. Results
+// are recorded as scalars at finish(), and a live summary is printed to
+// the console every PIPELINE_PROFILING_INTERVAL wall-clock seconds
+// (visible in Cmdenv express mode too).
+//
+
+#ifdef PIPELINE_PROFILING
+
+#include <omnetpp.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+
+using namespace omnetpp;
+
+#ifndef PIPELINE_PROFILING_SAMPLE
+#define PIPELINE_PROFILING_SAMPLE 16
+#endif
+
+#ifndef PIPELINE_PROFILING_INTERVAL
+#define PIPELINE_PROFILING_INTERVAL 10
+#endif
+
+namespace project {
+
+struct HandlerStats
+{
+    const char* name;
+    long events = 0;
+    long samples = 0;
+    double sampledNanos = 0;
+};
+
+class HandlerProfiler
+{
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    HandlerStats& getHandler(const char* name);
+    void observeQueue(long length) { peakQueue = std::max(peakQueue, length); }
+    void observeInFlight(long count) { peakInFlight = std::max(peakInFlight, count); }
+
+    // Called on every sampled event: tracks live messages, prints the summary
+    void sampled(cComponent* owner);
+
+    void recordScalars(cComponent* owner);
+
+  private:
+    void printSummary(cComponent* owner);
+
+    std::deque<HandlerStats> handlers;
+    long peakQueue = 0;
+    long peakInFlight = 0;
+    long peakLiveMessages = 0;  // per module, so it restarts with every run
+    Clock::time_point lastReport = Clock::now();
+};
+
+// Counts an event and samples its wall-clock cost for the enclosing scope
+class HandlerScope
+{
+  public:
+    HandlerScope(HandlerProfiler& profiler, cComponent* owner, const char* name)
+        : profiler(profiler), owner(owner), stats(profiler.getHandler(name)),
+          sampling(++stats.events % PIPELINE_PROFILING_SAMPLE == 0) {
+        if (sampling)
+            start = HandlerProfiler::Clock::now();
+    }
+
+    ~HandlerScope() {
+        if (!sampling)
+            return;
+        auto elapsed = HandlerProfiler::Clock::now() - start;
+        stats.samples++;
+        stats.sampledNanos += std::chrono::duration<double, std::nano>(elapsed).count();
+        profiler.sampled(owner);
+    }
+
+  private:
+    HandlerProfiler& profiler;
+    cComponent* owner;
+    HandlerStats& stats;
+    bool sampling;
+    HandlerProfiler::Clock::time_point start;
+};
+
+}; // namespace
+
+#define PROFILE_HANDLER(profiler, name) HandlerScope profileScope_(profiler, this, name)
+#define PROFILE_QUEUE(profiler, length) (profiler).observeQueue(length)
+#define PROFILE_INFLIGHT(profiler, count) (profiler).observeInFlight(count)
+#define PROFILE_RECORD(profiler) (profiler).recordScalars(this)
+
+#else
+
+#define PROFILE_HANDLER(profiler, name)
+#define PROFILE_QUEUE(profiler, length)
+#define PROFILE_INFLIGHT(profiler, count)
+#define PROFILE_RECORD(profiler)
+
+#endif
+
+#endif
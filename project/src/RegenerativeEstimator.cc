@@ -0,0 +1,50 @@
+#include "RegenerativeEstimator.h"
+#include <cmath>
+
+namespace project {
+
+void RatioEstimator::addCycle(double y, double x) {
+
+    n++;
+    double dy = y - meanY;
+    double dx = x - meanX;
+    meanY += dy / n;
+    meanX += dx / n;
+    comYY += dy * (y - meanY);
+    comXX += dx * (x - meanX);
+    comXY += dx * (y - meanY);
+}
+
+double RatioEstimator::getHalfWidth() const {
+
+    if (n < 2 || meanX <= 0)
+        return 0;
+
+    // Variance of Y - r X, with r the ratio estimate
+    double r = getEstimate();
+    double var = (comYY - 2 * r * comXY + r * r * comXX) / (n - 1);
+    if (var < 0)
+        var = 0;
+    return 1.96 * std::sqrt(var / n) / meanX;
+}
+
+RegenerativeEstimator::RegenerativeEstimator(double precision, long minCycles)
+    : precision(precision), minCycles(minCycles) {
+}
+
+void RegenerativeEstimator::addCycle(const RegenerationCycle& cycle) {
+    responseTime.addCycle(cycle.responseTimeSum, cycle.completions);
+    queueSize.addCycle(cycle.queueTime, cycle.length);
+    queueSize2.addCycle(cycle.queueTime2, cycle.length);
+    busyThreads.addCycle(cycle.busyThreadTime, cycle.length);
+}
+
+// Stopping rule on the response time, the main output of the model
+bool RegenerativeEstimator::isPrecisionReached() const {
+
+    if (precision <= 0 || getCycles() < minCycles)
+        return false;
+    return responseTime.getHalfWidth() <= precision * responseTime.getEstimate();
+}
+
+}; // namespace
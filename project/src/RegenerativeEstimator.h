@@ -0,0 +1,102 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+
+#ifndef REGENERATIVEESTIMATOR_H_
+#define REGENERATIVEESTIMATOR_H_
+
+namespace project {
+
+/**
+ * Ratio estimator over i.i.d. regeneration cycles: estimates E[Y] / E[X]
+ * from the cycle sums (Y_i, X_i), with the classical confidence interval
+ * of Crane and Iglehart. Co-moments are updated incrementally (Welford),
+ * so millions of cycles do not lose precision.
+ */
+class RatioEstimator
+{
+  public:
+    void addCycle(double y, double x);
+
+    long getCycles() const { return n; }
+    double getEstimate() const { return meanX > 0 ? meanY / meanX : 0; }
+
+    // Half width of the 95% confidence interval, 0 with less than 2 cycles
+    double getHalfWidth() const;
+
+  private:
+    long n = 0;
+    double meanY = 0;
+    double meanX = 0;
+    double comYY = 0;
+    double comXX = 0;
+    double comXY = 0;
+};
+
+/**
+ * Statistics of one regeneration cycle of the Pipeline network.
+ */
+struct RegenerationCycle
+{
+    double length = 0;           // cycle duration
+    long completions = 0;        // requests completed in the cycle
+    double responseTimeSum = 0;  // sum of their response times
+    double queueTime = 0;        // time integral of the stage-1 queue length
+    double queueTime2 = 0;       // time integral of the SecondStage queue length
+    double busyThreadTime = 0;   // time integral of the busy stage-1 threads
+};
+
+/**
+ * Regenerative estimator of the steady-state means of the Pipeline network.
+ *
+ * With Poisson clients the system regenerates whenever it becomes empty:
+ * every stage-1 thread is free, so no request is queued for a thread,
+ * holds the SecondStage lock or waits for it. The run splits into i.i.d.
+ * cycles between such points and every steady-state mean is a ratio of
+ * cycle sums, e.g. the mean response time is E[sum of the response times
+ * in a cycle] / E[completions in a cycle]. A single run thus gives
+ * confidence intervals with no warm-up bias and no replications.
+ *
+ * The run can stop as soon as the response time interval is narrow enough:
+ * its half width at most precision times the estimate, after at least
+ * minCycles cycles (the normal approximation needs many of them).
+ */
+class RegenerativeEstimator
+{
+  public:
+    RegenerativeEstimator(double precision, long minCycles);
+
+    void addCycle(const RegenerationCycle& cycle);
+    bool isPrecisionReached() const;
+
+    long getCycles() const { return responseTime.getCycles(); }
+    const RatioEstimator& getResponseTime() const { return responseTime; }
+    const RatioEstimator& getQueueSize() const { return queueSize; }
+    const RatioEstimator& getQueueSize2() const { return queueSize2; }
+    const RatioEstimator& getBusyThreads() const { return busyThreads; }
+
+  private:
+    double precision;
+    long minCycles;
+
+    RatioEstimator responseTime;  // per request
+    RatioEstimator queueSize;     // time averages
+    RatioEstimator queueSize2;
+    RatioEstimator busyThreads;
+};
+
+}; // namespace
+
+#endif
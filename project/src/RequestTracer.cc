@@ -0,0 +1,106 @@
+#include "RequestTracer.h"
+#include <omnetpp.h>
+#include <algorithm>
+#include <chrono>
+
+using namespace omnetpp;
+
+namespace project {
+
+RequestTracer::RequestTracer(const std::string& fileName, int poolId, size_t capacity, double samplingRate)
+    : buffer(capacity), samplingRate(samplingRate), head(0), tail(0), closing(false), recorded(0), dropped(0) {
+
+    if (capacity == 0)
+        throw cRuntimeError("RequestTracer: the trace buffer cannot be empty");
+
+    file = std::fopen(fileName.c_str(), "wb");
+    if (!file)
+        throw cRuntimeError("RequestTracer: cannot open trace file '%s'", fileName.c_str());
+
+    TraceFileHeader header = { {'P', 'T', 'R', 'C'}, TRACE_VERSION, sizeof(TraceRecord), (uint32_t)poolId };
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    writer = std::thread(&RequestTracer::writerLoop, this);
+}
+
+// Drains the remaining records and closes the file
+RequestTracer::~RequestTracer() {
+
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        closing = true;
+    }
+    wakeUp.notify_one();
+    writer.join();
+    std::fclose(file);
+}
+
+// Deterministic sampling: hashes the request ID to a number in [0, 1)
+bool RequestTracer::isSampled(long requestId) const {
+
+    if (samplingRate >= 1)
+        return true;
+
+    // splitmix64 finalizer
+    uint64_t z = (uint64_t)requestId + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+
+    return (z >> 11) * 0x1.0p-53 < samplingRate;
+}
+
+// Appends a record to the ring buffer, called by the simulation thread
+void RequestTracer::record(const TraceRecord& rec) {
+
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t used = h - tail.load(std::memory_order_acquire);
+
+    if (used == buffer.size()) {
+        dropped++;
+        return;
+    }
+
+    buffer[h % buffer.size()] = rec;
+    head.store(h + 1, std::memory_order_release);
+    recorded++;
+
+    // Wake the writer once half of the buffer is in use
+    if (used + 1 == buffer.size() / 2)
+        wakeUp.notify_one();
+}
+
+// Writes the records in [from, to) handling the wrap-around of the ring
+void RequestTracer::writeRange(size_t from, size_t to) {
+
+    size_t cap = buffer.size();
+    while (from < to) {
+        size_t begin = from % cap;
+        size_t count = std::min(to - from, cap - begin);
+        std::fwrite(&buffer[begin], sizeof(TraceRecord), count, file);
+        from += count;
+    }
+}
+
+// Background writer: flushes the buffer when woken up or periodically
+void RequestTracer::writerLoop() {
+
+    for (;;) {
+        bool done;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait_for(lock, std::chrono::milliseconds(100), [this] { return closing; });
+            done = closing;
+        }
+
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        writeRange(t, h);
+        tail.store(h, std::memory_order_release);
+
+        if (done)
+            break;
+    }
+}
+
+}; // namespace
@@ -0,0 +1,77 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+
+#ifndef REQUESTTRACER_H_
+#define REQUESTTRACER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TraceRecord.h"
+
+namespace project {
+
+/**
+ * Low-overhead recorder of per-request stage timelines.
+ *
+ * Records are copied into a preallocated ring buffer by the simulation
+ * thread and written to a binary file (see TraceRecord.h) by a background
+ * writer thread, so the simulation never blocks on I/O. If the writer falls
+ * behind and the buffer is full, records are dropped and counted.
+ *
+ * Sampling is a deterministic function of the request ID: it consumes no
+ * random numbers, so enabling tracing does not change the simulation.
+ */
+class RequestTracer
+{
+  public:
+    RequestTracer(const std::string& fileName, int poolId, size_t capacity, double samplingRate);
+    ~RequestTracer();
+
+    bool isSampled(long requestId) const;
+    void record(const TraceRecord& rec);
+
+    long getRecorded() const { return recorded; }
+    long getDropped() const { return dropped; }
+
+  private:
+    void writerLoop();
+    void writeRange(size_t from, size_t to);
+
+    std::vector<TraceRecord> buffer;
+    double samplingRate;
+    FILE* file;
+
+    // Single producer (simulation) / single consumer (writer) ring indices
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool closing;
+
+    long recorded;
+    long dropped;
+};
+
+}; // namespace
+
+#endif
@@ -21,6 +21,10 @@ void SecondStage::initialize() {
 
     // Lock indicates whether the stage is currently processing a request
     lock = false;
+
+    // Queue length integral, used by the regenerative estimator
+    queueTime = 0;
+    lastQueueChange = simTime();
 }
 
 // Returns a service delay based on the configured distribution
@@ -66,6 +70,8 @@ void SecondStage::handleServe2(PipelineMessage* msg) {
     long requestId = msg->getRequestId();
     int threadId = msg->getThreadId();
 
+    PROFILE_HANDLER(profiler, "handleServe2");
+
     // Debug Logging
     EV_DEBUG << "SecondStage::handleServe2 called." << endl;
 
@@ -78,10 +84,12 @@ void SecondStage::handleServe2(PipelineMessage* msg) {
 
     // The lock is already taken, queue the request and log
     if (lock) {
+        updateQueueTime();
         waitingRequests.insert(msg); //insert in FIFO queue
         EV_INFO << "Lock already taken, queuing request. Request ID: " << requestId
                 << " Thread ID: " << threadId << endl;
         emit(queueSize2, waitingRequests.getLength());
+        PROFILE_QUEUE(profiler, waitingRequests.getLength());
         return;
     }
     // Otherwise take the lock and schedule the completion of the request
@@ -100,6 +108,9 @@ void SecondStage::scheduleSecondStageProcessingCompletion(PipelineMessage* srcMs
     EV_DEBUG << "SecondStage::scheduleRequest called. requestId: " << requestId
              << ", threadId: " << threadId << ", clientId: " << clientId << endl;
 
+    // The lock is taken from now on
+    srcMsg->setStartSecond(simTime());
+
     // Schedule completion event using the same message
     srcMsg->setName("toServe3");
     simtime_t delay = getServiceDelay(threadId);
@@ -117,6 +128,8 @@ void SecondStage::handleSendToThirdStage(PipelineMessage* msg) {
     long requestId = msg->getRequestId();
     int threadId = msg->getThreadId();
 
+    PROFILE_HANDLER(profiler, "handleSendToThirdStage");
+
     // Debug Logging
     EV_DEBUG << "SecondStage::handleSendToThirdStage called." << endl;
 
@@ -130,6 +143,7 @@ void SecondStage::handleSendToThirdStage(PipelineMessage* msg) {
 
     // If there are queued requests, process the next one
     if (!waitingRequests.isEmpty()) {
+        updateQueueTime();
         PipelineMessage* nextMsg = check_and_cast<PipelineMessage*>(waitingRequests.pop());
         scheduleSecondStageProcessingCompletion(nextMsg);
         emit(queueSize2, waitingRequests.getLength());
@@ -146,5 +160,21 @@ void SecondStage::handleSendToThirdStage(PipelineMessage* msg) {
     send(msg, "out");
 }
 
+// Accumulates the queue length integral, called before every queue change
+void SecondStage::updateQueueTime() {
+    queueTime += waitingRequests.getLength() * (simTime() - lastQueueChange).dbl();
+    lastQueueChange = simTime();
+}
+
+// Returns the time integral of the queue length up to now
+double SecondStage::getQueueTimeIntegral() const {
+    return queueTime + waitingRequests.getLength() * (simTime() - lastQueueChange).dbl();
+}
+
+// Records profiling results, if enabled
+void SecondStage::finish() {
+    PROFILE_RECORD(profiler);
+}
+
 
 }; // namespace
@@ -18,6 +18,7 @@
 
 #include <omnetpp.h>
 #include "PipelineMessage_m.h"
+#include "Profiling.h"
 
 using namespace omnetpp;
 
@@ -26,13 +27,20 @@ namespace project {
 
 class SecondStage : public cSimpleModule
 {
+  public:
+    // Queried by FirstStage to detect regeneration points
+    bool isIdle() const { return !lock && waitingRequests.isEmpty(); }
+    double getQueueTimeIntegral() const;
+
   protected:
     virtual void initialize();
     virtual void handleMessage(cMessage *msg);
+    virtual void finish();
     virtual void handleSendToThirdStage(PipelineMessage* msg);
     virtual void handleServe2(PipelineMessage* msg);
     virtual void scheduleSecondStageProcessingCompletion(PipelineMessage* srcMsg);
     virtual simtime_t getServiceDelay(int threadId) const;
+    virtual void updateQueueTime();
 
   private:
     // Module parameters
@@ -44,9 +52,17 @@ class SecondStage : public cSimpleModule
     bool lock;
     cQueue waitingRequests;
 
+    // Time integral of the queue length, read by FirstStage before initialize()
+    double queueTime = 0;
+    simtime_t lastQueueChange;
+
     // Module statistic signals
     simsignal_t queueSize2;
     simsignal_t partialResponseTime2;
+
+#ifdef PIPELINE_PROFILING
+    HandlerProfiler profiler;
+#endif
 };
 
 
@@ -53,6 +53,8 @@ void ThirdStage::handleMessage(cMessage* msg) {
 // Handles a new request arriving from the second stage
 void ThirdStage::handleServe3(PipelineMessage* msg) {
 
+    PROFILE_HANDLER(profiler, "handleServe3");
+
     // Debug Logging
     EV_DEBUG << "ThirdStage::handleServe3 called" << endl;
 
@@ -94,6 +96,8 @@ void ThirdStage::scheduleThirdStageProcessingCompletion(PipelineMessage* srcMsg)
 // Handles a completed request and sends it back to first stage
 void ThirdStage::handleSendBackToFirstStage(PipelineMessage* msg) {
 
+    PROFILE_HANDLER(profiler, "handleSendBackToFirstStage");
+
     // Debug Logging
     EV_DEBUG << "ThirdStage::handleSendBackToFirstStage called." << endl;
 
@@ -101,8 +105,13 @@ void ThirdStage::handleSendBackToFirstStage(PipelineMessage* msg) {
     EV_INFO << "Request completed third stage. Request ID: " << msg->getRequestId()
             << " Thread ID: " << msg->getThreadId() << endl;
 
-    // send the message back to first stage
-    send(msg, "out");
+    // send the message back to the first stage pool owning its thread
+    send(msg, "out", msg->getPoolId());
+}
+
+// Records profiling results, if enabled
+void ThirdStage::finish() {
+    PROFILE_RECORD(profiler);
 }
 
 
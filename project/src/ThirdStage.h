@@ -18,6 +18,7 @@
 
 #include <omnetpp.h>
 #include "PipelineMessage_m.h"
+#include "Profiling.h"
 
 using namespace omnetpp;
 
@@ -28,6 +29,7 @@ class ThirdStage : public cSimpleModule
   protected:
     virtual void initialize();
     virtual void handleMessage(cMessage *msg);
+    virtual void finish();
     virtual void handleSendBackToFirstStage(PipelineMessage* msg);
     virtual void handleServe3(PipelineMessage* msg);
     virtual void scheduleThirdStageProcessingCompletion(PipelineMessage* srcMsg);
@@ -36,6 +38,10 @@ class ThirdStage : public cSimpleModule
   private:
     double meanServiceTime;
 
+#ifdef PIPELINE_PROFILING
+    HandlerProfiler profiler;
+#endif
+
 };
 
 }; // namespace
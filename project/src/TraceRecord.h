@@ -0,0 +1,57 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+
+#ifndef TRACERECORD_H_
+#define TRACERECORD_H_
+
+#include <cstdint>
+
+namespace project {
+
+/**
+ * On-disk layout of the request traces written by RequestTracer. Plain C++
+ * only, so that the tools can read the traces without OMNeT++.
+ *
+ * A trace file is a TraceFileHeader followed by TraceRecord entries, one
+ * per sampled request, in completion order. Times are simulation seconds.
+ */
+struct TraceFileHeader
+{
+    char magic[4];          // "PTRC"
+    uint32_t version;       // TRACE_VERSION
+    uint32_t recordSize;    // sizeof(TraceRecord)
+    uint32_t poolId;        // index of the FirstStage pool writing the file
+};
+
+struct TraceRecord
+{
+    int64_t requestId;
+    int32_t clientId;
+    int16_t poolId;
+    int16_t threadId;
+    double arrivalFirst;    // arrival at FirstStage
+    double startFirst;      // stage-1 thread assigned
+    double arrivalSecond;   // arrival at SecondStage
+    double startSecond;     // SecondStage lock acquired
+    double arrivalThird;    // lock released, arrival at ThirdStage
+    double completion;      // back at FirstStage, thread released
+};
+
+const uint32_t TRACE_VERSION = 1;
+
+}; // namespace
+
+#endif
@@ -0,0 +1,108 @@
+//
+// Analytical pre-screening of Pipeline sweep points.
+//
+// Predicts mean response time, utilizations and the saturation boundary
+// of every point of a sweep in a few milliseconds (see PipelineModel.h),
+// and classifies it as "stable", "saturated" or "simulate" when its load
+// is within the margin from the stability boundary. Only the last ones
+// are worth the full simulation budget.
+//
+// Build: g++ -O2 -std=c++17 -o analyticSolver AnalyticSolver.cc PipelineModel.cc
+//
+// Usage: analyticSolver -N 60,61,62 -K 5 -T 135 -dp 3 -dc 2 [-lognormal -std 0.54] [-margin 0.05]
+//   Comma separated values of -N, -K, -T and -dc are swept as a full grid.
+//
+
+#include "PipelineModel.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace project;
+
+// Parses a comma separated list of values
+template<typename T>
+static std::vector<T> parseList(const char* arg) {
+
+    std::vector<T> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        values.push_back((T)std::atof(item.c_str()));
+    return values;
+}
+
+static void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s -N <list> -K <list> -T <list> -dp <Dp> -dc <list> "
+                         "[-lognormal] [-std <w>] [-margin <m>]\n", prog);
+    std::exit(1);
+}
+
+int main(int argc, char** argv) {
+
+    PipelineParams base;
+    base.lognormalServiceTime2 = false;
+    std::vector<int> clients = {base.numClients};
+    std::vector<int> threads = {base.numThreads};
+    std::vector<double> requestMeanTimes = {base.requestMeanTime};
+    std::vector<double> lockTimes = {base.meanServiceTime2};
+    double margin = 0.05;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        const char* opt = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(opt, "-lognormal"))
+            base.lognormalServiceTime2 = true;
+        else if (!hasValue)
+            usage(argv[0]);
+        else if (!std::strcmp(opt, "-N"))
+            clients = parseList<int>(argv[++i]);
+        else if (!std::strcmp(opt, "-K"))
+            threads = parseList<int>(argv[++i]);
+        else if (!std::strcmp(opt, "-T"))
+            requestMeanTimes = parseList<double>(argv[++i]);
+        else if (!std::strcmp(opt, "-dc"))
+            lockTimes = parseList<double>(argv[++i]);
+        else if (!std::strcmp(opt, "-dp"))
+            base.meanServiceTime1 = base.meanServiceTime3 = std::atof(argv[++i]);
+        else if (!std::strcmp(opt, "-std"))
+            base.stdServiceTime2 = std::atof(argv[++i]);
+        else if (!std::strcmp(opt, "-margin"))
+            margin = std::atof(argv[++i]);
+        else
+            usage(argv[0]);
+    }
+
+    std::printf("%5s %4s %8s %6s | %7s %7s %6s | %9s %9s %9s | %6s %6s %8s %8s | %8s %8s %4s | %s\n",
+                "N", "K", "T", "Dc", "lambda", "X(K)", "load", "R", "W1", "W2",
+                "U1", "U2", "Q1", "Q2", "N*", "T*", "K*", "class");
+
+    // Solve the full grid of parameter points
+    for (int N : clients)
+        for (int K : threads)
+            for (double T : requestMeanTimes)
+                for (double Dc : lockTimes) {
+                    PipelineParams p = base;
+                    p.numClients = N;
+                    p.numThreads = K;
+                    p.requestMeanTime = T;
+                    p.meanServiceTime2 = Dc;
+
+                    AnalyticResult res = PipelineModel(p).solve();
+
+                    const char* cls = res.load < 1 - margin ? "stable"
+                                    : res.load >= 1 + margin ? "saturated" : "simulate";
+
+                    std::printf("%5d %4d %8g %6g | %7.4f %7.4f %6.3f | %9.4g %9.4g %9.4g | %6.3f %6.3f %8.4g %8.4g | %8.2f %8.2f %4d | %s\n",
+                                N, K, T, Dc, res.arrivalRate, res.maxThroughput, res.load,
+                                res.responseTime, res.threadWaitTime, res.lockWaitTime,
+                                res.threadUtilization, res.lockUtilization, res.queueSize, res.queueSize2,
+                                res.maxClients, res.minRequestMeanTime, res.minThreads, cls);
+                }
+
+    return 0;
+}
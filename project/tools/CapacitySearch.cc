@@ -0,0 +1,446 @@
+//
+// Automated capacity search for the Pipeline model.
+//
+// Finds the largest number of clients N, the smallest number of threads K
+// or the smallest requestMeanTime that still meets a target, which is
+// either a mean response time (-latency <s>) or stability (-stability).
+//
+// The analytical model (PipelineModel.h) gives the initial guess, then the
+// boundary is bracketed and bisected with short OMNeT++ runs. Every point
+// is decided with as few replications as possible: replications are added
+// only while the confidence interval of the metric still contains the
+// target, so points far from the boundary cost minReps runs and close ones
+// up to maxReps. Runs whose stage-1 queue exceeds -maxqueue are ended early
+// by FirstStage (maxQueueSize parameter). Every run gets an rng-k mapping
+// sized for its own N and K, so clients and threads never share a stream,
+// whatever the RNG mapping of the config covers, and num-rngs large enough
+// for both mappings. The simulator is started directly (fork/exec), so
+// paths are passed as they are.
+//
+// Build: g++ -O2 -std=c++17 -o capacitySearch CapacitySearch.cc IniConfig.cc PipelineModel.cc
+//
+// Usage (from the simulations folder):
+//   capacitySearch -search N -stability -K 5 -T 135 -dp 3 -dc 2
+//   capacitySearch -search K -latency 20 -N 60 -T 135 -dp 3 -dc 0.56 -lognormal -std 0.54
+//
+
+#include "IniConfig.h"
+#include "PipelineModel.h"
+#include "StudentT.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace project;
+
+namespace {
+
+struct SearchOptions
+{
+    // Searched parameter: 'N', 'K' or 'T' (requestMeanTime)
+    char searchParam = 'N';
+
+    // Target: mean response time <= latencyTarget, or stability only
+    bool stabilityTarget = true;
+    double latencyTarget = 0;
+
+    // A run is unstable if more than this fraction of the arrivals is left
+    // in the stage-1 queue at the end of the run
+    double backlogTolerance = 0.02;
+
+    // Replications and short runs
+    int minReps = 3;
+    int maxReps = 20;
+    double simTime = 5000;
+    double warmup = 0;
+    int maxQueueSize = 1000;
+    double step = 1;
+
+    // OMNeT++ invocation
+    std::string executable = "../src/project";
+    std::string iniFile = "omnetpp.ini";
+    std::string config = "DataAnalysisBase";
+    std::string nedPath = ".:../src";
+    std::string outputDir = "capacity-search";
+};
+
+struct RunResult
+{
+    double responseTime = 0;
+    double backlogFraction = 0;
+};
+
+SearchOptions opts;
+int runCounter = 0;
+
+// num-rngs of the config, which its own rng-k mapping is sized for
+int configRngs = 1;
+
+// Same formatting as an ostream, for the numeric options
+std::string formatValue(double value) {
+    std::ostringstream ss;
+    ss << value;
+    return ss.str();
+}
+
+// Runs a command without a shell, with stdout and stderr sent to logFile.
+// Returns true if it exited with status 0
+bool execute(const std::vector<std::string>& args, const std::string& logFile) {
+
+    std::vector<char*> argv;
+    for (const std::string& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0) {
+        int fd = open(logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            _exit(127);
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+        execvp(argv[0], argv.data());
+        std::perror(argv[0]);
+        _exit(127);
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0)
+        if (errno != EINTR)
+            return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Sets the searched parameter in the parameter point
+void applyValue(PipelineParams& p, double value) {
+
+    if (opts.searchParam == 'N')
+        p.numClients = (int)value;
+    else if (opts.searchParam == 'K')
+        p.numThreads = (int)value;
+    else
+        p.requestMeanTime = value;
+}
+
+// Runs one short OMNeT++ replication and extracts the stage-1 scalars
+RunResult runSimulation(const PipelineParams& p, int rep) {
+
+    std::string base = opts.outputDir + "/run" + std::to_string(runCounter++);
+    std::string scaFile = base + ".sca";
+
+    std::vector<std::string> args = {
+        opts.executable, "-u", "Cmdenv", "-c", opts.config, "-r", "0", "-n", opts.nedPath,
+        "--cmdenv-express-mode=true", "--repeat=1", "--seed-set=" + std::to_string(rep),
+        "--sim-time-limit=" + formatValue(opts.simTime) + "s",
+        "--warmup-period=" + formatValue(opts.warmup) + "s",
+        "--output-scalar-file=" + scaFile, "--**.vector-recording=false",
+        "--**.clients.numClients=" + std::to_string(p.numClients),
+        "--**.clients.requestMeanTime=" + formatValue(p.requestMeanTime),
+        "--**.stage1.numThreads=" + std::to_string(p.numThreads),
+        "--**.stage1.meanServiceTime=" + formatValue(p.meanServiceTime1),
+        "--**.stage1.maxQueueSize=" + std::to_string(opts.maxQueueSize),
+        "--**.stage2.meanServiceTime=" + formatValue(p.meanServiceTime2),
+        "--**.stage2.stdServiceTime=" + formatValue(p.stdServiceTime2),
+        std::string("--**.stage2.lognormalServiceTime=") + (p.lognormalServiceTime2 ? "true" : "false"),
+        "--**.stage3.meanServiceTime=" + formatValue(p.meanServiceTime3)};
+
+    // Dedicated RNG streams for every client and thread of this point, as
+    // the mapping of the config only covers its own sweep range. Clients
+    // use rng-<clientId>, the stages rng-<threadId> with thread IDs 1..K.
+    // The higher rng-k entries of the config still apply, so num-rngs must
+    // cover them too
+    int stream = 0;
+    for (int client = 0; client < p.numClients; client++)
+        args.push_back("--**.clients.rng-" + std::to_string(client) + "=" + std::to_string(stream++));
+    for (const char* stage : {"stage1", "stage2", "stage3"})
+        for (int thread = 0; thread <= p.numThreads; thread++)
+            args.push_back(std::string("--**.") + stage + ".rng-" + std::to_string(thread) + "=" + std::to_string(stream++));
+    args.push_back("--num-rngs=" + std::to_string(std::max(stream, configRngs)));
+    args.push_back(opts.iniFile);
+
+    if (!execute(args, base + ".log")) {
+        std::fprintf(stderr, "Simulation failed, see %s.log\n", base.c_str());
+        std::exit(1);
+    }
+
+    // Scalar lines: scalar <module> <name> <value>
+    std::ifstream in(scaFile);
+    std::string line;
+    double backlogRate = 0;
+    std::map<std::string, double> responseMean, responseCount;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string kind, module, name;
+        double value;
+        if (!(ss >> kind >> module >> name >> value) || kind != "scalar")
+            continue;
+
+        if (name == "responseTime:mean")
+            responseMean[module] = value;
+        else if (name == "responseTime:count")
+            responseCount[module] = value;
+        else if (name == "backlogRate")
+            backlogRate += value;
+    }
+
+    // Mean over all the modules, weighted by their number of responses
+    double weightedResponse = 0, count = 0;
+    for (const auto& entry : responseCount) {
+        auto mean = responseMean.find(entry.first);
+        if (mean == responseMean.end())
+            continue;
+        weightedResponse += mean->second * entry.second;
+        count += entry.second;
+    }
+
+    RunResult res;
+    res.responseTime = count > 0 ? weightedResponse / count : 0;
+    res.backlogFraction = backlogRate / p.arrivalRate();
+    return res;
+}
+
+// Decides whether a point meets the target with adaptive replications
+bool simulationMeets(const PipelineParams& p) {
+
+    double threshold = opts.stabilityTarget ? opts.backlogTolerance : opts.latencyTarget;
+    double sum = 0, sumSq = 0;
+    double mean = 0, half = 0;
+    int n = 0;
+
+    while (n < opts.maxReps) {
+        RunResult r = runSimulation(p, n);
+        n++;
+
+        // An unstable run fails a latency target whatever its mean is
+        if (!opts.stabilityTarget && r.backlogFraction > opts.backlogTolerance) {
+            std::printf("    rep %d unstable (backlog %.3f), target missed\n", n, r.backlogFraction);
+            return false;
+        }
+
+        double sample = opts.stabilityTarget ? r.backlogFraction : r.responseTime;
+        sum += sample;
+        sumSq += sample * sample;
+        if (n < opts.minReps)
+            continue;
+
+        mean = sum / n;
+        double var = std::max(0.0, (sumSq - n * mean * mean) / (n - 1));
+        half = tQuantile95(n - 1) * std::sqrt(var / n);
+
+        // Stop as soon as the confidence interval excludes the threshold
+        if (mean + half <= threshold || mean - half > threshold)
+            break;
+    }
+
+    bool meets = mean <= threshold;
+    std::printf("    %d reps, metric %.4g +- %.4g -> %s\n", n, mean, half, meets ? "meets" : "misses");
+    return meets;
+}
+
+// Analytical counterpart of simulationMeets, used for the initial guess
+bool analyticMeets(const PipelineParams& p) {
+
+    AnalyticResult res = PipelineModel(p).solve();
+    return opts.stabilityTarget ? res.stable : res.responseTime <= opts.latencyTarget;
+}
+
+// Finds the last value meeting the target between lo (meets) and hi (fails)
+double bisect(double lo, double hi, const std::function<bool(double)>& meets) {
+
+    bool integer = opts.searchParam != 'T';
+    while (std::fabs(hi - lo) > opts.step) {
+        double mid = (lo + hi) / 2;
+        if (integer)
+            mid = std::trunc(mid);
+        if (mid == lo || mid == hi)
+            break;
+        if (meets(mid))
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Brackets the boundary around a guess. Larger N is harder, larger K and
+// requestMeanTime easier: failDir is the direction in which the target is
+// missed and limit the bound in the opposite direction.
+bool bracket(double guess, double failDir, double limit, const std::function<bool(double)>& meets,
+             double& lo, double& hi) {
+
+    double step = std::max(opts.step, std::fabs(guess) * 0.05);
+    if (opts.searchParam != 'T')
+        step = std::ceil(step);
+
+    // K and requestMeanTime cannot be decreased below the smallest value
+    double failLimit = opts.searchParam == 'N' ? INFINITY : opts.step;
+
+    if (meets(guess)) {
+        lo = guess;
+        for (;;) {
+            hi = lo + failDir * step;
+            if ((hi - failLimit) * failDir >= 0)
+                hi = failLimit;
+            if (!meets(hi))
+                return true;
+            lo = hi;
+            if (hi == failLimit)
+                return true;
+            step *= 2;
+        }
+    }
+
+    hi = guess;
+    for (;;) {
+        lo = hi - failDir * step;
+        if ((lo - limit) * failDir <= 0)
+            lo = limit;
+        if (meets(lo))
+            return true;
+        if (lo == limit)
+            return false;
+        hi = lo;
+        step *= 2;
+    }
+}
+
+// Full search: bracket and bisect, caching the decided points
+bool search(const PipelineParams& base, double guess, const std::function<bool(const PipelineParams&)>& decide,
+            bool verbose, double& result) {
+
+    std::map<double, bool> decided;
+    auto meets = [&](double value) {
+        auto it = decided.find(value);
+        if (it != decided.end())
+            return it->second;
+        PipelineParams p = base;
+        applyValue(p, value);
+        if (verbose)
+            std::printf("  %c = %g\n", opts.searchParam, value);
+        return decided[value] = decide(p);
+    };
+
+    double failDir = opts.searchParam == 'N' ? 1 : -1;
+    double limit = opts.searchParam == 'N' ? 1 : opts.searchParam == 'K' ? 4096 : 1e9;
+
+    double lo, hi;
+    if (!bracket(guess, failDir, limit, meets, lo, hi))
+        return false;
+
+    result = bisect(lo, hi, meets);
+    return true;
+}
+
+void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s -search N|K|T (-stability | -latency <s>) -N <N> -K <K> -T <T> -dp <Dp> -dc <Dc>\n"
+                         "          [-lognormal] [-std <w>] [-tolerance <f>] [-minreps <n>] [-maxreps <n>]\n"
+                         "          [-simtime <s>] [-warmup <s>] [-maxqueue <n>] [-step <v>]\n"
+                         "          [-exe <path>] [-ini <file>] [-c <config>] [-ned <path>] [-out <dir>]\n", prog);
+    std::exit(1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+    PipelineParams base;
+    base.lognormalServiceTime2 = false;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        std::string opt = argv[i];
+        if (opt == "-stability") {
+            opts.stabilityTarget = true;
+            continue;
+        }
+        if (opt == "-lognormal") {
+            base.lognormalServiceTime2 = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            usage(argv[0]);
+
+        const char* value = argv[++i];
+        if (opt == "-search") opts.searchParam = value[0];
+        else if (opt == "-latency") { opts.stabilityTarget = false; opts.latencyTarget = std::atof(value); }
+        else if (opt == "-N") base.numClients = std::atoi(value);
+        else if (opt == "-K") base.numThreads = std::atoi(value);
+        else if (opt == "-T") base.requestMeanTime = std::atof(value);
+        else if (opt == "-dp") base.meanServiceTime1 = base.meanServiceTime3 = std::atof(value);
+        else if (opt == "-dc") base.meanServiceTime2 = std::atof(value);
+        else if (opt == "-std") base.stdServiceTime2 = std::atof(value);
+        else if (opt == "-tolerance") opts.backlogTolerance = std::atof(value);
+        else if (opt == "-minreps") opts.minReps = std::max(2, std::atoi(value));
+        else if (opt == "-maxreps") opts.maxReps = std::atoi(value);
+        else if (opt == "-simtime") opts.simTime = std::atof(value);
+        else if (opt == "-warmup") opts.warmup = std::atof(value);
+        else if (opt == "-maxqueue") opts.maxQueueSize = std::atoi(value);
+        else if (opt == "-step") opts.step = std::atof(value);
+        else if (opt == "-exe") opts.executable = value;
+        else if (opt == "-ini") opts.iniFile = value;
+        else if (opt == "-c") opts.config = value;
+        else if (opt == "-ned") opts.nedPath = value;
+        else if (opt == "-out") opts.outputDir = value;
+        else usage(argv[0]);
+    }
+
+    if (!std::strchr("NKT", opts.searchParam))
+        usage(argv[0]);
+    opts.maxReps = std::max(opts.maxReps, opts.minReps);
+
+    // N and K are integers: a finer step would never end the bisection
+    if (opts.searchParam != 'T')
+        opts.step = std::max(1.0, std::round(opts.step));
+
+    // Streams the config maps itself, which every run must still provide
+    try {
+        IniConfig ini(opts.iniFile);
+        std::vector<RunConfig> runs = ini.getRuns(opts.config);
+        const std::string* numRngs = runs.empty() ? nullptr : runs.front().getOption("num-rngs");
+        if (numRngs)
+            configRngs = std::max(1, std::atoi(numRngs->c_str()));
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    // Initial guess from the analytical model, starting from the current value
+    double current = opts.searchParam == 'N' ? base.numClients
+                   : opts.searchParam == 'K' ? base.numThreads : base.requestMeanTime;
+    double guess = current;
+    if (!search(base, current, analyticMeets, false, guess)) {
+        std::printf("Analytical model: target not reachable, starting from %g\n", current);
+        guess = current;
+    }
+    else
+        std::printf("Analytical model: %c = %g\n", opts.searchParam, guess);
+
+    // Simulation-based search around the guess
+    std::filesystem::create_directories(opts.outputDir);
+    double result;
+    if (!search(base, guess, simulationMeets, true, result)) {
+        std::printf("Target not reachable within the search range (%d runs)\n", runCounter);
+        return 2;
+    }
+
+    std::printf("Result: %s %c = %g (%d runs)\n", opts.searchParam == 'N' ? "max" : "min",
+                opts.searchParam, result, runCounter);
+    return 0;
+}
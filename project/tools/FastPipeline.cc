@@ -0,0 +1,404 @@
+#include "FastPipeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace project {
+
+namespace {
+
+// Strict "a comes after b" order of the event set
+inline bool later(const FastEvent& a, const FastEvent& b) {
+    return a.time > b.time || (a.time == b.time && a.seq > b.seq);
+}
+
+uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+CalendarQueue::CalendarQueue()
+    : buckets(2), mask(1), width(1), count(0), currentSlot(0), topValid(false), topBucket(0) {
+}
+
+void CalendarQueue::push(const FastEvent& event) {
+
+    if (count + 1 > 2 * buckets.size())
+        resize(2 * buckets.size());
+
+    // Keep the bucket sorted, latest first
+    uint64_t slot = slotOf(event.time);
+    std::vector<FastEvent>& bucket = buckets[slot & mask];
+    bucket.insert(std::upper_bound(bucket.begin(), bucket.end(), event, later), event);
+    count++;
+
+    // The scan never starts after the earliest event
+    if (slot < currentSlot) {
+        currentSlot = slot;
+        topValid = false;
+    }
+    else if (topValid && later(buckets[topBucket].back(), event))
+        topValid = false;
+}
+
+const FastEvent& CalendarQueue::top() {
+    if (!topValid)
+        findNext();
+    return buckets[topBucket].back();
+}
+
+FastEvent CalendarQueue::pop() {
+
+    FastEvent event = top();
+    buckets[topBucket].pop_back();
+    count--;
+    topValid = false;
+
+    if (buckets.size() > 2 && count < buckets.size() / 2)
+        resize(buckets.size() / 2);
+    return event;
+}
+
+// Scans the calendar from the current slot for the earliest event
+void CalendarQueue::findNext() {
+
+    for (size_t i = 0; i < buckets.size(); i++, currentSlot++) {
+        const std::vector<FastEvent>& bucket = buckets[currentSlot & mask];
+        if (!bucket.empty() && slotOf(bucket.back().time) <= currentSlot) {
+            topBucket = currentSlot & mask;
+            topValid = true;
+            return;
+        }
+    }
+
+    // A whole year without events: jump directly to the earliest one
+    const FastEvent* earliest = nullptr;
+    for (size_t b = 0; b < buckets.size(); b++) {
+        if (!buckets[b].empty() && (!earliest || later(*earliest, buckets[b].back()))) {
+            earliest = &buckets[b].back();
+            topBucket = b;
+        }
+    }
+    currentSlot = slotOf(earliest->time);
+    topValid = true;
+}
+
+// Rebuilds the calendar with a new bucket count and bucket width
+void CalendarQueue::resize(size_t numBuckets) {
+
+    std::vector<FastEvent> all;
+    all.reserve(count);
+    for (std::vector<FastEvent>& bucket : buckets)
+        all.insert(all.end(), bucket.begin(), bucket.end());
+    std::sort(all.begin(), all.end(), later);
+
+    // Width: three times the mean spacing of the next events, ignoring
+    // the spacings larger than twice the first estimate
+    size_t samples = std::min<size_t>(all.size(), 26);
+    if (samples > 2) {
+        double span = all[all.size() - 1].time;
+        double mean = (all[all.size() - samples].time - span) / (samples - 1);
+        double sum = 0;
+        int used = 0;
+        for (size_t i = all.size() - samples + 1; i < all.size(); i++) {
+            double gap = all[i - 1].time - all[i].time;
+            if (gap <= 2 * mean) {
+                sum += gap;
+                used++;
+            }
+        }
+        if (used > 0 && sum > 0)
+            width = 3 * sum / used;
+    }
+
+    buckets.assign(numBuckets, std::vector<FastEvent>());
+    mask = numBuckets - 1;
+    for (const FastEvent& event : all)
+        buckets[slotOf(event.time) & mask].push_back(event);
+
+    currentSlot = all.empty() ? 0 : slotOf(all.back().time);
+    topValid = false;
+}
+
+void SlotQueue::grow() {
+
+    std::vector<uint32_t> larger(2 * buffer.size());
+    for (size_t i = 0; i < count; i++)
+        larger[i] = buffer[(head + i) & (buffer.size() - 1)];
+    buffer.swap(larger);
+    head = 0;
+}
+
+FastRng::FastRng(uint64_t seed, uint64_t stream) {
+    uint64_t x = seed * 0x9E3779B97F4A7C15ULL + stream;
+    for (uint64_t& word : s)
+        word = splitmix64(x);
+}
+
+double FastRng::exponential(double mean) {
+    return -mean * std::log(1 - uniform01());
+}
+
+// Marsaglia polar method, the second value is kept for the next call
+double FastRng::normal(double mean, double stddev) {
+
+    if (hasSpare) {
+        hasSpare = false;
+        return mean + stddev * spare;
+    }
+
+    double u, v, s2;
+    do {
+        u = 2 * uniform01() - 1;
+        v = 2 * uniform01() - 1;
+        s2 = u * u + v * v;
+    } while (s2 >= 1 || s2 == 0);
+
+    double factor = std::sqrt(-2 * std::log(s2) / s2);
+    spare = v * factor;
+    hasSpare = true;
+    return mean + stddev * u * factor;
+}
+
+// Same parametrization as OMNeT++: exp of a normal(m, w) variate
+double FastRng::lognormal(double m, double w) {
+    return std::exp(normal(m, w));
+}
+
+FastPipeline::FastPipeline(const PipelineParams& params, const FastRunOptions& options)
+    : params(params), options(options),
+      clientRng(options.seed, 0), firstRng(options.seed, 1), secondRng(options.seed, 2), thirdRng(options.seed, 3),
+      availableThreads(params.numThreads),
+      regenerative(options.regenerativePrecision, options.regenerativeMinCycles) {
+
+    if (options.simTimeLimit <= 0)
+        throw std::invalid_argument("FastPipeline: a positive sim-time-limit is required");
+    if (params.numClients < 0 || params.numThreads < 1)
+        throw std::invalid_argument("FastPipeline: invalid numClients or numThreads");
+}
+
+void FastPipeline::schedule(double time, EventKind kind, uint32_t index) {
+    events.push(FastEvent{time, nextSeq++, (uint32_t)kind, index});
+}
+
+// Returns a free request slot, growing the state arrays if needed
+uint32_t FastPipeline::allocateSlot() {
+
+    if (!freeSlots.empty()) {
+        uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+    arrivalFirst.push_back(0);
+    arrivalSecond.push_back(0);
+    return (uint32_t)(arrivalFirst.size() - 1);
+}
+
+// Discards what was collected during the warm-up period
+void FastPipeline::resetStatistics(double time) {
+
+    responseCount = 0;
+    responseSum = 0;
+    responseMax = 0;
+    partialCount = 0;
+    partialSum = 0;
+    partialCount2 = 0;
+    partialSum2 = 0;
+    statsStart = time;
+
+    for (TimeAverage* avg : {&queueSize, &queueSize2, &busyThreads}) {
+        avg->set(time, avg->value);
+        avg->integral = 0;
+        avg->last = time;
+        avg->max = avg->value;
+    }
+}
+
+FastResult FastPipeline::run() {
+
+    auto wallStart = std::chrono::steady_clock::now();
+    FastResult res;
+
+    for (int client = 0; client < params.numClients; client++)
+        schedule(clientRng.exponential(params.requestMeanTime), CLIENT_REQUEST, client);
+
+    bool warmedUp = options.warmupPeriod <= 0;
+    while (!events.empty() && !stopped) {
+        if (events.top().time > options.simTimeLimit)
+            break;
+
+        FastEvent event = events.pop();
+        now = event.time;
+        if (!warmedUp && now >= options.warmupPeriod) {
+            resetStatistics(options.warmupPeriod);
+            warmedUp = true;
+        }
+        res.events++;
+
+        switch (event.kind) {
+            case CLIENT_REQUEST:    handleClientRequest(event.index); break;
+            case FIRST_STAGE_DONE:  handleFirstStageDone(event.index); break;
+            case SECOND_STAGE_DONE: handleSecondStageDone(event.index); break;
+            case THIRD_STAGE_DONE:  handleThirdStageDone(event.index); break;
+        }
+    }
+
+    // The run ends at the time limit, or at the queue overflow
+    double end = stopped ? now : options.simTimeLimit;
+    if (!warmedUp)
+        resetStatistics(end);
+    for (TimeAverage* avg : {&queueSize, &queueSize2, &busyThreads})
+        avg->set(end, avg->value);
+
+    double elapsed = end - statsStart;
+    res.endTime = end;
+    res.queueLimitExceeded = queueLimitExceeded;
+    res.responseTimeCount = responseCount;
+    res.responseTimeMean = responseCount > 0 ? responseSum / responseCount : NAN;
+    res.responseTimeMax = responseMax;
+    res.partialRequestTimeMean = partialCount > 0 ? partialSum / partialCount : NAN;
+    res.partialResponseTime2Mean = partialCount2 > 0 ? partialSum2 / partialCount2 : NAN;
+    res.queueSizeTimeavg = elapsed > 0 ? queueSize.integral / elapsed : queueSize.value;
+    res.queueSizeMax = queueSize.max;
+    res.queueSize2Timeavg = elapsed > 0 ? queueSize2.integral / elapsed : queueSize2.value;
+    res.queueSize2Max = queueSize2.max;
+    res.busyThreadsTimeavg = elapsed > 0 ? busyThreads.integral / elapsed : busyThreads.value;
+    res.backlogRate = end > 0 ? waitingRequests.size() / end : 0;
+
+    if (options.regenerative) {
+        res.regenCycles = regenerative.getCycles();
+        res.regenPrecisionReached = regenerative.isPrecisionReached();
+        res.regenResponseTime = regenerative.getResponseTime().getEstimate();
+        res.regenResponseTimeCI = regenerative.getResponseTime().getHalfWidth();
+        res.regenQueueSize = regenerative.getQueueSize().getEstimate();
+        res.regenQueueSizeCI = regenerative.getQueueSize().getHalfWidth();
+        res.regenQueueSize2 = regenerative.getQueueSize2().getEstimate();
+        res.regenQueueSize2CI = regenerative.getQueueSize2().getHalfWidth();
+        res.regenBusyThreads = regenerative.getBusyThreads().getEstimate();
+        res.regenBusyThreadsCI = regenerative.getBusyThreads().getHalfWidth();
+    }
+    res.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    return res;
+}
+
+// ClientStage: send the request and schedule the client's next one
+void FastPipeline::handleClientRequest(uint32_t client) {
+
+    uint32_t slot = allocateSlot();
+    arrivalFirst[slot] = now;
+    schedule(now + clientRng.exponential(params.requestMeanTime), CLIENT_REQUEST, client);
+
+    // FirstStage::handleServe
+    if (availableThreads == 0) {
+        waitingRequests.push(slot);
+        queueSize.set(now, waitingRequests.size());
+        if (options.maxQueueSize >= 0 && (long)waitingRequests.size() > options.maxQueueSize)
+            stopped = queueLimitExceeded = true;
+    }
+    else {
+        availableThreads--;
+        busyThreads.set(now, params.numThreads - availableThreads);
+        startFirstStage(slot);
+    }
+}
+
+void FastPipeline::startFirstStage(uint32_t slot) {
+    schedule(now + firstRng.uniform(0, 2 * params.meanServiceTime1), FIRST_STAGE_DONE, slot);
+}
+
+// FirstStage::handleSecondStage followed by SecondStage::handleServe2
+void FastPipeline::handleFirstStageDone(uint32_t slot) {
+
+    partialCount++;
+    partialSum += now - arrivalFirst[slot];
+
+    arrivalSecond[slot] = now;
+    if (lock) {
+        waitingRequests2.push(slot);
+        queueSize2.set(now, waitingRequests2.size());
+        return;
+    }
+    lock = true;
+    startSecondStage(slot);
+}
+
+void FastPipeline::startSecondStage(uint32_t slot) {
+
+    double delay = params.lognormalServiceTime2 ? secondRng.lognormal(params.meanServiceTime2, params.stdServiceTime2)
+                                                : secondRng.uniform(0, 2 * params.meanServiceTime2);
+    schedule(now + delay, SECOND_STAGE_DONE, slot);
+}
+
+// SecondStage::handleSendToThirdStage followed by ThirdStage::handleServe3
+void FastPipeline::handleSecondStageDone(uint32_t slot) {
+
+    partialCount2++;
+    partialSum2 += now - arrivalSecond[slot];
+
+    if (!waitingRequests2.empty()) {
+        startSecondStage(waitingRequests2.pop());
+        queueSize2.set(now, waitingRequests2.size());
+    }
+    else
+        lock = false;
+
+    schedule(now + thirdRng.uniform(0, 2 * params.meanServiceTime3), THIRD_STAGE_DONE, slot);
+}
+
+// FirstStage::handleEnd: the request leaves and its thread is reused
+void FastPipeline::handleThirdStageDone(uint32_t slot) {
+
+    double response = now - arrivalFirst[slot];
+    responseCount++;
+    responseSum += response;
+    responseMax = std::max(responseMax, response);
+    freeSlots.push_back(slot);
+    cycleCompletions++;
+    cycleResponseTime += response;
+
+    if (!waitingRequests.empty()) {
+        startFirstStage(waitingRequests.pop());
+        queueSize.set(now, waitingRequests.size());
+    }
+    else {
+        availableThreads++;
+        busyThreads.set(now, params.numThreads - availableThreads);
+
+        // Every thread free: no request left anywhere, a regeneration point
+        if (options.regenerative && availableThreads == params.numThreads && !lock)
+            regenerationPoint();
+    }
+}
+
+void FastPipeline::startCycle() {
+    cycleStart = now;
+    cycleCompletions = 0;
+    cycleResponseTime = 0;
+    cycleQueueTime = queueSize.totalAt(now);
+    cycleQueueTime2 = queueSize2.totalAt(now);
+    cycleBusyThreadTime = busyThreads.totalAt(now);
+}
+
+// Closes the current regeneration cycle, stops at the target precision
+void FastPipeline::regenerationPoint() {
+
+    RegenerationCycle cycle;
+    cycle.length = now - cycleStart;
+    cycle.completions = cycleCompletions;
+    cycle.responseTimeSum = cycleResponseTime;
+    cycle.queueTime = queueSize.totalAt(now) - cycleQueueTime;
+    cycle.queueTime2 = queueSize2.totalAt(now) - cycleQueueTime2;
+    cycle.busyThreadTime = busyThreads.totalAt(now) - cycleBusyThreadTime;
+    regenerative.addCycle(cycle);
+    startCycle();
+
+    if (regenerative.isPrecisionReached())
+        stopped = true;
+}
+
+}; // namespace
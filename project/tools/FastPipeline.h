@@ -0,0 +1,290 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef FASTPIPELINE_H_
+#define FASTPIPELINE_H_
+
+#include "PipelineModel.h"
+#include "../src/RegenerativeEstimator.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace project {
+
+/**
+ * Event of the standalone kernel: a plain struct, no allocation per event.
+ * Ties are broken by insertion order, as in the OMNeT++ event set.
+ */
+struct FastEvent
+{
+    double time;
+    uint64_t seq;
+    uint32_t kind;     // FastPipeline::EventKind
+    uint32_t index;    // client ID or request slot
+};
+
+/**
+ * Calendar queue (R. Brown, 1988): events are hashed by time into buckets
+ * of a fixed width, so enqueue and dequeue are O(1) on average. The number
+ * of buckets follows the number of pending events and the width is
+ * re-estimated from the event spacing at every resize.
+ */
+class CalendarQueue
+{
+  public:
+    CalendarQueue();
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    const FastEvent& top();
+    void push(const FastEvent& event);
+    FastEvent pop();
+
+  private:
+    uint64_t slotOf(double time) const { return (uint64_t)(time / width); }
+    void findNext();
+    void resize(size_t numBuckets);
+
+    // Each bucket is kept sorted with the earliest event at the back
+    std::vector<std::vector<FastEvent>> buckets;
+    size_t mask;
+    double width;
+    size_t count;
+    uint64_t currentSlot;   // calendar slot being scanned
+    bool topValid;
+    size_t topBucket;
+};
+
+/**
+ * Growable FIFO ring of request slots.
+ */
+class SlotQueue
+{
+  public:
+    SlotQueue() : buffer(16), head(0), count(0) {}
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void push(uint32_t slot) {
+        if (count == buffer.size())
+            grow();
+        buffer[(head + count++) & (buffer.size() - 1)] = slot;
+    }
+
+    uint32_t pop() {
+        uint32_t slot = buffer[head];
+        head = (head + 1) & (buffer.size() - 1);
+        count--;
+        return slot;
+    }
+
+  private:
+    void grow();
+
+    std::vector<uint32_t> buffer;
+    size_t head;
+    size_t count;
+};
+
+/**
+ * xoshiro256+ generator, seeded with splitmix64 from (seed, stream).
+ */
+class FastRng
+{
+  public:
+    FastRng(uint64_t seed, uint64_t stream);
+
+    // Uniform in [0, 1)
+    double uniform01() {
+        uint64_t result = s[0] + s[3];
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = (s[3] << 45) | (s[3] >> 19);
+        return (result >> 11) * 0x1.0p-53;
+    }
+
+    double uniform(double a, double b) { return a + (b - a) * uniform01(); }
+    double exponential(double mean);
+    double normal(double mean, double stddev);
+    double lognormal(double m, double w);
+
+  private:
+    uint64_t s[4];
+    bool hasSpare = false;
+    double spare = 0;
+};
+
+/**
+ * Run options, with the same meaning as the omnetpp.ini options.
+ */
+struct FastRunOptions
+{
+    double simTimeLimit = 0;     // sim-time-limit, required
+    double warmupPeriod = 0;     // warmup-period
+    uint64_t seed = 0;           // seed-set
+    long maxQueueSize = -1;      // stage1.maxQueueSize, -1: unlimited
+
+    // stage1.regenerative, regenerativePrecision and regenerativeMinCycles
+    bool regenerative = false;
+    double regenerativePrecision = 0.01;
+    long regenerativeMinCycles = 1000;
+};
+
+/**
+ * Scalars of one run, named after the OMNeT++ statistics they match.
+ */
+struct FastResult
+{
+    uint64_t events = 0;
+    double endTime = 0;
+    double wallTime = 0;          // seconds
+    bool queueLimitExceeded = false;
+
+    // stage1
+    long responseTimeCount = 0;
+    double responseTimeMean = 0;
+    double responseTimeMax = 0;
+    double partialRequestTimeMean = 0;
+    double queueSizeTimeavg = 0;
+    double queueSizeMax = 0;
+    double busyThreadsTimeavg = 0;
+    double backlogRate = 0;
+
+    // stage2
+    double partialResponseTime2Mean = 0;
+    double queueSize2Timeavg = 0;
+    double queueSize2Max = 0;
+
+    // Regenerative estimates and 95% CI half widths, if enabled
+    long regenCycles = 0;
+    bool regenPrecisionReached = false;
+    double regenResponseTime = 0;
+    double regenResponseTimeCI = 0;
+    double regenQueueSize = 0;
+    double regenQueueSizeCI = 0;
+    double regenQueueSize2 = 0;
+    double regenQueueSize2CI = 0;
+    double regenBusyThreads = 0;
+    double regenBusyThreadsCI = 0;
+};
+
+/**
+ * Standalone simulation kernel for the Pipeline network.
+ *
+ * It reproduces the semantics of ClientStage, FirstStage, SecondStage and
+ * ThirdStage (open-loop Poisson clients, K stage-1 threads held until the
+ * request completes, FIFO queues in front of the threads and the lock)
+ * without modules, gates, signals or message objects: pending events are
+ * FastEvent values in a CalendarQueue and the per-request state lives in
+ * parallel arrays indexed by a recycled request slot. Random streams are
+ * independent of the OMNeT++ ones, so runs agree in distribution only.
+ * Regenerative estimation works as in FirstStage (RegenerativeEstimator.h).
+ */
+class FastPipeline
+{
+  public:
+    enum EventKind { CLIENT_REQUEST, FIRST_STAGE_DONE, SECOND_STAGE_DONE, THIRD_STAGE_DONE };
+
+    FastPipeline(const PipelineParams& params, const FastRunOptions& options);
+
+    FastResult run();
+
+  private:
+    // Time-weighted value, as recorded by the timeavg statistic. The
+    // total integral is not reset at the end of the warm-up period
+    struct TimeAverage
+    {
+        double value = 0;
+        double last = 0;
+        double integral = 0;
+        double total = 0;
+        double max = 0;
+
+        double totalAt(double now) const { return total + value * (now - last); }
+
+        void set(double now, double newValue) {
+            integral += value * (now - last);
+            total += value * (now - last);
+            last = now;
+            value = newValue;
+            if (newValue > max)
+                max = newValue;
+        }
+    };
+
+    void schedule(double time, EventKind kind, uint32_t index);
+    uint32_t allocateSlot();
+    void startFirstStage(uint32_t slot);
+    void startSecondStage(uint32_t slot);
+    void resetStatistics(double time);
+    void startCycle();
+    void regenerationPoint();
+
+    void handleClientRequest(uint32_t client);
+    void handleFirstStageDone(uint32_t slot);
+    void handleSecondStageDone(uint32_t slot);
+    void handleThirdStageDone(uint32_t slot);
+
+    PipelineParams params;
+    FastRunOptions options;
+    FastRng clientRng, firstRng, secondRng, thirdRng;
+
+    CalendarQueue events;
+    uint64_t nextSeq = 0;
+    double now = 0;
+    bool stopped = false;
+    bool queueLimitExceeded = false;
+
+    // Request state, one entry per slot
+    std::vector<double> arrivalFirst;
+    std::vector<double> arrivalSecond;
+    std::vector<uint32_t> freeSlots;
+
+    int availableThreads;
+    bool lock = false;
+    SlotQueue waitingRequests;     // stage 1
+    SlotQueue waitingRequests2;    // stage 2 (lock)
+
+    // Statistics
+    long responseCount = 0;
+    double responseSum = 0;
+    double responseMax = 0;
+    long partialCount = 0;
+    double partialSum = 0;
+    long partialCount2 = 0;
+    double partialSum2 = 0;
+    double statsStart = 0;
+    TimeAverage queueSize, queueSize2, busyThreads;
+
+    // Regenerative estimation: sums of the current cycle, and the total
+    // integrals at its start
+    RegenerativeEstimator regenerative;
+    double cycleStart = 0;
+    long cycleCompletions = 0;
+    double cycleResponseTime = 0;
+    double cycleQueueTime = 0;
+    double cycleQueueTime2 = 0;
+    double cycleBusyThreadTime = 0;
+};
+
+}; // namespace
+
+#endif
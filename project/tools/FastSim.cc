@@ -0,0 +1,401 @@
+//
+// Runs an omnetpp.ini configuration of the Pipeline network with the
+// standalone kernel (FastPipeline.h) instead of OMNeT++.
+//
+// Parameters, iteration variables, repeat, seed-set, sim-time-limit and
+// warmup-period are taken from the ini file, so the same sweep can be run
+// by both engines. For every sweep point the mean and 95% confidence
+// interval over the repetitions are printed for the scalars both engines
+// record. With -validate, the OMNeT++ runs of the same configuration
+// packed into a result store (resultPack) are matched by their iteration
+// variables and every metric is checked: the difference of the two means
+// must stay within the combined confidence intervals. With -o the runs are
+// appended to a result store themselves (engine attribute "fastsim"), so
+// resultQuery works on them too. Runs with stage1.regenerative = true also
+// print their single-run regenerative estimates.
+//
+// The kernel executes 4 events per request where OMNeT++ executes 8 (every
+// send is an event too): compare engines by requests/s, not events/s.
+//
+// Build: g++ -O2 -std=c++17 -pthread -o fastSim FastSim.cc FastPipeline.cc IniConfig.cc PipelineModel.cc ResultStore.cc
+//        ../src/RegenerativeEstimator.cc
+//
+// Usage (from the simulations folder):
+//   fastSim -c ContinuityTestBase
+//   fastSim -c DataAnalysis_SweepN_Uniform -r 0..99 -j 8 -o fast.rst
+//   fastSim -c Degenracy-Test -validate omnet.rst
+//
+
+#include "FastPipeline.h"
+#include "IniConfig.h"
+#include "ResultStore.h"
+#include "StudentT.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace project;
+
+namespace {
+
+struct SimOptions
+{
+    std::string iniFile = "omnetpp.ini";
+    std::string config;
+    std::string runFilter;
+    std::string storeFile;
+    std::string validateFile;
+    int jobs = std::max(1u, std::thread::hardware_concurrency());
+    bool verbose = false;
+};
+
+struct Job
+{
+    RunConfig config;
+    PipelineParams params;
+    FastRunOptions options;
+    FastResult result;
+};
+
+// Metrics compared between the engines: module, OMNeT++ scalar name, value
+struct Metric
+{
+    const char* module;
+    const char* name;
+    double (*get)(const FastResult&);
+};
+
+const Metric metrics[] = {
+    { "stage1", "responseTime:mean",    [](const FastResult& r) { return r.responseTimeMean; } },
+    { "stage1", "queueSize:timeavg",    [](const FastResult& r) { return r.queueSizeTimeavg; } },
+    { "stage1", "busyThreads:timeavg",  [](const FastResult& r) { return r.busyThreadsTimeavg; } },
+    { "stage2", "queueSize2:timeavg",   [](const FastResult& r) { return r.queueSize2Timeavg; } },
+};
+
+struct Accumulator
+{
+    long n = 0;
+    double sum = 0;
+    double sumSq = 0;
+
+    void add(double value) {
+        n++;
+        sum += value;
+        sumSq += value * value;
+    }
+    double mean() const { return sum / n; }
+    double halfWidth() const {
+        if (n < 2)
+            return 0;
+        double var = std::max(0.0, (sumSq - n * mean() * mean()) / (n - 1));
+        return tQuantile95(n - 1) * std::sqrt(var / n);
+    }
+};
+
+SimOptions opts;
+
+// Accepts "3", "0..9" and comma separated lists of both
+bool runSelected(int runNumber) {
+
+    if (opts.runFilter.empty())
+        return true;
+
+    size_t begin = 0;
+    while (begin <= opts.runFilter.size()) {
+        size_t comma = opts.runFilter.find(',', begin);
+        std::string item = opts.runFilter.substr(begin, comma - begin);
+        size_t range = item.find("..");
+        int from = std::atoi(item.c_str());
+        int to = range == std::string::npos ? from : std::atoi(item.c_str() + range + 2);
+        if (runNumber >= from && runNumber <= to)
+            return true;
+        if (comma == std::string::npos)
+            break;
+        begin = comma + 1;
+    }
+    return false;
+}
+
+// Reads the NED parameters of the Pipeline network, defaults as in the NED files
+Job makeJob(const RunConfig& config) {
+
+    const std::string* networkOption = config.getOption("network");
+    std::string network = networkOption ? *networkOption : "";
+    if (network.size() > 9 && network.compare(network.size() - 9, 9, ".Pipeline") == 0)
+        network = "Pipeline";
+    if (network != "Pipeline")
+        throw std::runtime_error("only the Pipeline network is supported, config '" + config.configName
+                                 + "' uses '" + network + "'");
+
+    Job job;
+    job.config = config;
+    PipelineParams& p = job.params;
+    p.numClients = config.getInt("Pipeline.clients.numClients", 10);
+    p.requestMeanTime = config.getDouble("Pipeline.clients.requestMeanTime", 10);
+    p.numThreads = config.getInt("Pipeline.stage1.numThreads", 2);
+    p.meanServiceTime1 = config.getDouble("Pipeline.stage1.meanServiceTime", 10);
+    p.meanServiceTime2 = config.getDouble("Pipeline.stage2.meanServiceTime", 10);
+    p.stdServiceTime2 = config.getDouble("Pipeline.stage2.stdServiceTime", 1);
+    p.lognormalServiceTime2 = config.getBool("Pipeline.stage2.lognormalServiceTime", true);
+    p.meanServiceTime3 = config.getDouble("Pipeline.stage3.meanServiceTime", 10);
+
+    FastRunOptions& o = job.options;
+    o.simTimeLimit = config.getTime("sim-time-limit", 0);
+    o.warmupPeriod = config.getTime("warmup-period", 0);
+    o.maxQueueSize = config.getInt("Pipeline.stage1.maxQueueSize", -1);
+    o.regenerative = config.getBool("Pipeline.stage1.regenerative", false);
+    o.regenerativePrecision = config.getDouble("Pipeline.stage1.regenerativePrecision", 0.01);
+    o.regenerativeMinCycles = config.getInt("Pipeline.stage1.regenerativeMinCycles", 1000);
+    const std::string* seedSet = config.getOption("seed-set");
+    o.seed = seedSet ? std::strtoull(seedSet->c_str(), nullptr, 10) : config.runNumber;
+
+    if (o.simTimeLimit <= 0)
+        throw std::runtime_error("config '" + config.configName + "' has no sim-time-limit");
+    return job;
+}
+
+// Sweep point of a run: its iteration variables except the repetition
+std::string pointKey(const std::vector<std::pair<std::string, std::string>>& itervars) {
+
+    std::map<std::string, std::string> sorted(itervars.begin(), itervars.end());
+    std::string key;
+    for (const auto& var : sorted)
+        if (var.first != "repetition")
+            key += (key.empty() ? "" : " ") + var.first + "=" + var.second;
+    return key.empty() ? "-" : key;
+}
+
+void appendToStore(const Job& job) {
+
+    RunBuilder run;
+    run.addAttribute("runId", "fastsim-" + job.config.configName + "-" + std::to_string(job.config.runNumber));
+    run.addAttribute("engine", "fastsim");
+    run.addAttribute("configname", job.config.configName);
+    run.addAttribute("runnumber", std::to_string(job.config.runNumber));
+    run.addAttribute("repetition", std::to_string(job.config.repetition));
+    run.addAttribute("seedset", std::to_string(job.options.seed));
+    for (const auto& var : job.config.iterationVariables)
+        run.addAttribute("itervar:" + var.first, var.second);
+
+    const FastResult& r = job.result;
+    run.addScalar("Pipeline.stage1", "responseTime:mean", r.responseTimeMean);
+    run.addScalar("Pipeline.stage1", "responseTime:count", r.responseTimeCount);
+    run.addScalar("Pipeline.stage1", "responseTime:max", r.responseTimeMax);
+    run.addScalar("Pipeline.stage1", "partialRequestTime:mean", r.partialRequestTimeMean);
+    run.addScalar("Pipeline.stage1", "queueSize:timeavg", r.queueSizeTimeavg);
+    run.addScalar("Pipeline.stage1", "queueSize:max", r.queueSizeMax);
+    run.addScalar("Pipeline.stage1", "busyThreads:timeavg", r.busyThreadsTimeavg);
+    run.addScalar("Pipeline.stage1", "backlogRate", r.backlogRate);
+    run.addScalar("Pipeline.stage2", "partialResponseTime2:mean", r.partialResponseTime2Mean);
+    run.addScalar("Pipeline.stage2", "queueSize2:timeavg", r.queueSize2Timeavg);
+    run.addScalar("Pipeline.stage2", "queueSize2:max", r.queueSize2Max);
+    if (job.options.regenerative) {
+        run.addScalar("Pipeline.stage1", "regenCycles", r.regenCycles);
+        run.addScalar("Pipeline.stage1", "regenPrecisionReached", r.regenPrecisionReached);
+        run.addScalar("Pipeline.stage1", "regenResponseTime", r.regenResponseTime);
+        run.addScalar("Pipeline.stage1", "regenResponseTimeCI", r.regenResponseTimeCI);
+        run.addScalar("Pipeline.stage1", "regenQueueSize", r.regenQueueSize);
+        run.addScalar("Pipeline.stage1", "regenQueueSizeCI", r.regenQueueSizeCI);
+        run.addScalar("Pipeline.stage1", "regenQueueSize2", r.regenQueueSize2);
+        run.addScalar("Pipeline.stage1", "regenQueueSize2CI", r.regenQueueSize2CI);
+        run.addScalar("Pipeline.stage1", "regenBusyThreads", r.regenBusyThreads);
+        run.addScalar("Pipeline.stage1", "regenBusyThreadsCI", r.regenBusyThreadsCI);
+    }
+    run.addScalar("Pipeline", "events", (double)r.events);
+    run.addScalar("Pipeline", "wallTime", r.wallTime);
+    appendRun(opts.storeFile, run);
+}
+
+// Compares the fast runs with the OMNeT++ runs of a result store
+bool validate(const std::map<std::string, std::vector<Accumulator>>& fast) {
+
+    ResultStoreReader store(opts.validateFile);
+
+    // OMNeT++ scalars of the same config, per sweep point and metric
+    std::map<std::string, std::vector<Accumulator>> omnet;
+    for (size_t r = 0; r < store.getNumRuns(); r++) {
+        const ResultStoreReader::Run& run = store.getRun(r);
+        const char* config = run.getAttribute("configname");
+        const char* engine = run.getAttribute("engine");
+        if (!config || opts.config != config || engine)
+            continue;
+
+        std::vector<std::pair<std::string, std::string>> itervars;
+        for (size_t i = 0; i < run.getNumAttributes(); i++)
+            if (!std::strncmp(run.getAttributeKey(i), "itervar:", 8))
+                itervars.push_back({run.getAttributeKey(i) + 8, run.getAttributeValue(i)});
+
+        std::vector<Accumulator>& accs = omnet[pointKey(itervars)];
+        accs.resize(std::size(metrics));
+        for (size_t i = 0; i < run.getNumScalars(); i++) {
+            std::string module = run.getScalarModule(i);
+            for (size_t m = 0; m < std::size(metrics); m++) {
+                std::string suffix = std::string(".") + metrics[m].module;
+                if (module.size() >= suffix.size() && module.compare(module.size() - suffix.size(), suffix.size(), suffix) == 0
+                        && !std::strcmp(run.getScalarName(i), metrics[m].name))
+                    accs[m].add(run.getScalarValue(i));
+            }
+        }
+    }
+
+    std::printf("\nValidation against %s\n", opts.validateFile.c_str());
+    std::printf("%-32s %-22s %24s %24s %8s\n", "point", "metric", "fastsim", "omnet++", "result");
+
+    int compared = 0, failed = 0;
+    for (const auto& point : fast) {
+        auto it = omnet.find(point.first);
+        if (it == omnet.end()) {
+            std::printf("%-32s no OMNeT++ runs\n", point.first.c_str());
+            continue;
+        }
+        for (size_t m = 0; m < std::size(metrics); m++) {
+            const Accumulator& f = point.second[m];
+            const Accumulator& o = it->second[m];
+            if (f.n == 0 || o.n == 0)
+                continue;
+
+            double tolerance = std::sqrt(f.halfWidth() * f.halfWidth() + o.halfWidth() * o.halfWidth());
+            bool ok = std::fabs(f.mean() - o.mean()) <= tolerance;
+            compared++;
+            failed += !ok;
+            std::printf("%-32s %-22s %11.5g +- %-9.3g %11.5g +- %-9.3g %8s\n", point.first.c_str(), metrics[m].name,
+                        f.mean(), f.halfWidth(), o.mean(), o.halfWidth(), ok ? "ok" : "DIFFERS");
+        }
+    }
+    std::printf("%d of %d comparisons within the combined 95%% confidence intervals\n", compared - failed, compared);
+    return compared > 0 && failed == 0;
+}
+
+void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-f <ini>] -c <config> [-r <runs>] [-j <threads>] [-o <store>] "
+                         "[-validate <store>] [-v]\n", prog);
+    std::exit(1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-f") && i + 1 < argc)
+            opts.iniFile = argv[++i];
+        else if (!std::strcmp(argv[i], "-c") && i + 1 < argc)
+            opts.config = argv[++i];
+        else if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
+            opts.runFilter = argv[++i];
+        else if (!std::strcmp(argv[i], "-j") && i + 1 < argc)
+            opts.jobs = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "-o") && i + 1 < argc)
+            opts.storeFile = argv[++i];
+        else if (!std::strcmp(argv[i], "-validate") && i + 1 < argc)
+            opts.validateFile = argv[++i];
+        else if (!std::strcmp(argv[i], "-v"))
+            opts.verbose = true;
+        else
+            usage(argv[0]);
+    }
+    if (opts.config.empty())
+        usage(argv[0]);
+
+    try {
+        IniConfig ini(opts.iniFile);
+        std::vector<Job> jobs;
+        for (const RunConfig& config : ini.getRuns(opts.config))
+            if (runSelected(config.runNumber))
+                jobs.push_back(makeJob(config));
+        if (jobs.empty())
+            throw std::runtime_error("no runs selected");
+
+        // Runs are independent: spread them over the worker threads
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<size_t> next(0);
+        std::mutex outputMutex;
+        std::vector<std::thread> workers;
+        for (int w = 0; w < std::min<int>(opts.jobs, jobs.size()); w++) {
+            workers.emplace_back([&]() {
+                for (size_t j; (j = next++) < jobs.size(); ) {
+                    FastPipeline sim(jobs[j].params, jobs[j].options);
+                    jobs[j].result = sim.run();
+                    if (opts.verbose) {
+                        std::lock_guard<std::mutex> guard(outputMutex);
+                        const FastResult& r = jobs[j].result;
+                        std::printf("run #%d: %lu events, %.3fs, responseTime %.5g%s\n", jobs[j].config.runNumber,
+                                    (unsigned long)r.events, r.wallTime, r.responseTimeMean,
+                                    r.queueLimitExceeded ? " (maxQueueSize exceeded)" : "");
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Aggregate the repetitions of every sweep point
+        std::map<std::string, std::vector<Accumulator>> points;
+        uint64_t events = 0;
+        long requests = 0;
+        for (const Job& job : jobs) {
+            std::vector<Accumulator>& accs = points[pointKey(job.config.iterationVariables)];
+            accs.resize(std::size(metrics));
+            for (size_t m = 0; m < std::size(metrics); m++)
+                if (!std::isnan(metrics[m].get(job.result)))
+                    accs[m].add(metrics[m].get(job.result));
+            events += job.result.events;
+            requests += job.result.responseTimeCount;
+            if (!opts.storeFile.empty())
+                appendToStore(job);
+        }
+
+        std::printf("%-32s %5s", "point", "n");
+        for (const Metric& metric : metrics)
+            std::printf(" %24s", metric.name);
+        std::printf("\n");
+        for (const auto& point : points) {
+            std::printf("%-32s %5ld", point.first.c_str(), point.second[0].n);
+            for (const Accumulator& acc : point.second)
+                std::printf(" %11.5g +- %-9.3g", acc.n ? acc.mean() : NAN, acc.halfWidth());
+            std::printf("\n");
+        }
+        // Single-run estimates of the regenerative runs
+        bool header = true;
+        for (const Job& job : jobs) {
+            if (!job.options.regenerative)
+                continue;
+            if (header) {
+                std::printf("\nRegenerative estimates\n%-32s %5s %9s %8s %24s %24s %24s %24s\n", "point", "run",
+                            "cycles", "endTime", "responseTime", "queueSize", "busyThreads", "queueSize2");
+                header = false;
+            }
+            const FastResult& r = job.result;
+            std::printf("%-32s %5d %9ld %8.4g %11.5g +- %-9.3g %11.5g +- %-9.3g %11.5g +- %-9.3g %11.5g +- %-9.3g%s\n",
+                        pointKey(job.config.iterationVariables).c_str(), job.config.runNumber, r.regenCycles, r.endTime,
+                        r.regenResponseTime, r.regenResponseTimeCI, r.regenQueueSize, r.regenQueueSizeCI,
+                        r.regenBusyThreads, r.regenBusyThreadsCI, r.regenQueueSize2, r.regenQueueSize2CI,
+                        r.regenPrecisionReached ? "" : " (precision not reached)");
+        }
+
+        std::printf("%zu runs, %lu events in %.3fs on %d threads: %.3g events/s, %.3g requests/s\n", jobs.size(),
+                    (unsigned long)events, elapsed, std::min<int>(opts.jobs, jobs.size()), events / elapsed,
+                    requests / elapsed);
+
+        if (!opts.validateFile.empty() && !validate(points))
+            return 2;
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "fastSim: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
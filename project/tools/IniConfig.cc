@@ -0,0 +1,372 @@
+#include "IniConfig.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+namespace project {
+
+namespace {
+
+std::string trim(const std::string& str) {
+    size_t begin = str.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos)
+        return "";
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(begin, end - begin + 1);
+}
+
+// Removes a trailing comment, ignoring '#' inside quoted strings
+std::string stripComment(const std::string& line) {
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        if (line[i] == '"')
+            quoted = !quoted;
+        else if (line[i] == '#' && !quoted)
+            return line.substr(0, i);
+    }
+    return line;
+}
+
+std::vector<std::string> splitList(const std::string& str) {
+    std::vector<std::string> items;
+    size_t begin = 0;
+    while (true) {
+        size_t comma = str.find(',', begin);
+        items.push_back(trim(str.substr(begin, comma - begin)));
+        if (comma == std::string::npos)
+            break;
+        begin = comma + 1;
+    }
+    return items;
+}
+
+// OMNeT++ key patterns: "**" matches anything, "*" and "?" do not cross dots
+bool matchPattern(const char* pattern, const char* str) {
+
+    if (*pattern == 0)
+        return *str == 0;
+
+    if (pattern[0] == '*' && pattern[1] == '*') {
+        for (const char* s = str; ; s++) {
+            if (matchPattern(pattern + 2, s))
+                return true;
+            if (*s == 0)
+                return false;
+        }
+    }
+    if (*pattern == '*') {
+        for (const char* s = str; ; s++) {
+            if (matchPattern(pattern + 1, s))
+                return true;
+            if (*s == 0 || *s == '.')
+                return false;
+        }
+    }
+    if (*str == 0)
+        return false;
+    if (*pattern == '?' ? *str != '.' : *pattern == *str)
+        return matchPattern(pattern + 1, str + 1);
+    return false;
+}
+
+struct IterationVariable
+{
+    std::string name;
+    std::vector<std::string> values;
+};
+
+// Values of an iteration variable body: "1,2,3" or "1..10 step 2"
+std::vector<std::string> parseValues(const std::string& body) {
+
+    size_t range = body.find("..");
+    if (range == std::string::npos || body.find(',') != std::string::npos)
+        return splitList(body);
+
+    double from = std::atof(body.substr(0, range).c_str());
+    std::string rest = body.substr(range + 2);
+    double step = 1;
+    size_t stepPos = rest.find("step");
+    if (stepPos != std::string::npos) {
+        step = std::atof(rest.substr(stepPos + 4).c_str());
+        rest = rest.substr(0, stepPos);
+    }
+    double to = std::atof(rest.c_str());
+    if (step <= 0)
+        throw std::runtime_error("invalid step in iteration '${" + body + "}'");
+
+    std::vector<std::string> values;
+    for (int i = 0; from + i * step <= to + 1e-9 * step; i++) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%g", from + i * step);
+        values.push_back(buf);
+    }
+    return values;
+}
+
+// Collects the variables defined (not just referenced) in a value
+void collectVariables(const std::string& value, std::vector<IterationVariable>& vars, int& unnamed) {
+
+    size_t pos = 0;
+    while ((pos = value.find("${", pos)) != std::string::npos) {
+        size_t end = value.find('}', pos);
+        if (end == std::string::npos)
+            throw std::runtime_error("unterminated '${' in '" + value + "'");
+        std::string body = value.substr(pos + 2, end - pos - 2);
+        pos = end + 1;
+
+        size_t eq = body.find('=');
+        std::string name;
+        if (eq != std::string::npos) {
+            name = trim(body.substr(0, eq));
+            body = body.substr(eq + 1);
+        }
+        else if (body.find(',') != std::string::npos || body.find("..") != std::string::npos)
+            name = std::to_string(unnamed++);
+        else
+            continue;  // ${name} reference
+
+        bool known = false;
+        for (const IterationVariable& var : vars)
+            known = known || var.name == name;
+        if (!known)
+            vars.push_back({name, parseValues(body)});
+    }
+}
+
+// Replaces every ${...} with the value of its variable in this run
+std::string substitute(const std::string& value, const std::map<std::string, std::string>& values, int& unnamed) {
+
+    std::string result;
+    size_t pos = 0;
+    while (true) {
+        size_t start = value.find("${", pos);
+        if (start == std::string::npos)
+            break;
+        size_t end = value.find('}', start);
+        std::string body = value.substr(start + 2, end - start - 2);
+        result += value.substr(pos, start - pos);
+        pos = end + 1;
+
+        size_t eq = body.find('=');
+        std::string name;
+        if (eq != std::string::npos)
+            name = trim(body.substr(0, eq));
+        else if (body.find(',') != std::string::npos || body.find("..") != std::string::npos)
+            name = std::to_string(unnamed++);
+        else
+            name = trim(body);
+
+        auto it = values.find(name);
+        if (it == values.end())
+            throw std::runtime_error("unknown iteration variable '" + name + "'");
+        result += it->second;
+    }
+    return result + value.substr(pos);
+}
+
+// Strips the quotes of a string value
+std::string unquote(const std::string& value) {
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+        return value.substr(1, value.size() - 2);
+    return value;
+}
+
+} // namespace
+
+IniConfig::IniConfig(const std::string& fileName) {
+
+    std::ifstream in(fileName);
+    if (!in)
+        throw std::runtime_error("cannot open ini file '" + fileName + "'");
+
+    Section* section = nullptr;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = trim(stripComment(line));
+        if (line.empty())
+            continue;
+
+        if (line.front() == '[') {
+            if (line.back() != ']')
+                throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": malformed section header");
+            std::string name = trim(line.substr(1, line.size() - 2));
+            if (name.compare(0, 7, "Config ") == 0)
+                name = trim(name.substr(7));
+            section = &sections[name];
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos)
+            throw std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": '=' expected");
+        if (!section)
+            section = &sections["General"];
+        section->push_back({trim(line.substr(0, eq)), trim(line.substr(eq + 1))});
+    }
+}
+
+// Lookup order of a configuration: itself, the sections it extends, General
+std::vector<std::string> IniConfig::getSectionChain(const std::string& configName) const {
+
+    std::vector<std::string> chain;
+    std::vector<std::string> pending = {configName};
+    while (!pending.empty()) {
+        std::string name = pending.front();
+        pending.erase(pending.begin());
+
+        bool seen = false;
+        for (const std::string& s : chain)
+            seen = seen || s == name;
+        if (seen || name == "General")
+            continue;
+
+        auto it = sections.find(name);
+        if (it == sections.end())
+            throw std::runtime_error("no such config: '" + name + "'");
+        chain.push_back(name);
+
+        for (const auto& entry : it->second)
+            if (entry.first == "extends")
+                for (const std::string& base : splitList(entry.second))
+                    pending.push_back(base);
+    }
+    if (sections.count("General"))
+        chain.push_back("General");
+    return chain;
+}
+
+std::vector<RunConfig> IniConfig::getRuns(const std::string& configName) const {
+
+    std::vector<std::string> chain = getSectionChain(configName);
+
+    // Entries in lookup order, and the iteration variables they define
+    Section entries;
+    for (const std::string& name : chain)
+        for (const auto& entry : sections.at(name))
+            if (entry.first != "extends")
+                entries.push_back(entry);
+
+    std::vector<IterationVariable> vars;
+    int unnamed = 0;
+    for (const auto& entry : entries)
+        collectVariables(entry.second, vars, unnamed);
+
+    // The first matching entry wins, as for parameters
+    int repeat = 1;
+    for (const auto& entry : entries)
+        if (entry.first == "repeat") {
+            repeat = std::atoi(entry.second.c_str());
+            break;
+        }
+
+    size_t numPoints = 1;
+    for (const IterationVariable& var : vars)
+        numPoints *= var.values.size();
+
+    // The first variable is the outermost loop, repetitions the innermost one
+    std::vector<RunConfig> runs;
+    for (size_t point = 0; point < numPoints; point++) {
+        for (int rep = 0; rep < repeat; rep++) {
+            RunConfig run;
+            run.configName = configName;
+            run.runNumber = (int)runs.size();
+            run.repetition = rep;
+
+            std::map<std::string, std::string> values;
+            size_t index = point;
+            for (size_t v = vars.size(); v-- > 0; ) {
+                const IterationVariable& var = vars[v];
+                values[var.name] = var.values[index % var.values.size()];
+                index /= var.values.size();
+            }
+            for (const IterationVariable& var : vars)
+                run.iterationVariables.push_back({var.name, values[var.name]});
+
+            values["repetition"] = std::to_string(rep);
+            values["runnumber"] = std::to_string(run.runNumber);
+            values["configname"] = configName;
+
+            int counter = 0;
+            for (const auto& entry : entries)
+                run.entries.push_back({entry.first, substitute(entry.second, values, counter)});
+            runs.push_back(run);
+        }
+    }
+    return runs;
+}
+
+const std::string* RunConfig::getOption(const std::string& key) const {
+    for (const auto& entry : entries)
+        if (entry.first == key)
+            return &entry.second;
+    return nullptr;
+}
+
+const std::string* RunConfig::getParameter(const std::string& path) const {
+    for (const auto& entry : entries)
+        if (entry.first.find('.') != std::string::npos && matchPattern(entry.first.c_str(), path.c_str()))
+            return &entry.second;
+    return nullptr;
+}
+
+double RunConfig::getDouble(const std::string& path, double defaultValue) const {
+
+    const std::string* value = getParameter(path);
+    if (!value || *value == "default")
+        return defaultValue;
+
+    char* end;
+    double result = std::strtod(value->c_str(), &end);
+    if (end == value->c_str() || *end)
+        throw std::runtime_error("'" + path + "': cannot evaluate '" + *value + "'");
+    return result;
+}
+
+long RunConfig::getInt(const std::string& path, long defaultValue) const {
+
+    double value = getDouble(path, (double)defaultValue);
+    if (value != (long)value)
+        throw std::runtime_error("'" + path + "': integer value expected");
+    return (long)value;
+}
+
+bool RunConfig::getBool(const std::string& path, bool defaultValue) const {
+
+    const std::string* value = getParameter(path);
+    if (!value || *value == "default")
+        return defaultValue;
+    if (*value == "true")
+        return true;
+    if (*value == "false")
+        return false;
+    throw std::runtime_error("'" + path + "': boolean value expected, got '" + *value + "'");
+}
+
+double RunConfig::getTime(const std::string& key, double defaultValue) const {
+
+    const std::string* value = getOption(key);
+    if (!value)
+        return defaultValue;
+
+    std::string str = unquote(*value);
+    char* end;
+    double result = std::strtod(str.c_str(), &end);
+    std::string unit = trim(end);
+    if (unit == "" || unit == "s")
+        return result;
+    if (unit == "ms")
+        return result * 1e-3;
+    if (unit == "us")
+        return result * 1e-6;
+    if (unit == "min")
+        return result * 60;
+    if (unit == "h")
+        return result * 3600;
+    throw std::runtime_error("'" + key + "': unsupported time value '" + *value + "'");
+}
+
+}; // namespace
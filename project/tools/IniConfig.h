@@ -0,0 +1,81 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef INICONFIG_H_
+#define INICONFIG_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace project {
+
+/**
+ * One run of an ini configuration: the entries visible from its section
+ * (own section first, then the extended ones, then General) with the
+ * iteration variables already substituted.
+ */
+class RunConfig
+{
+  public:
+    std::string configName;
+    int runNumber = 0;
+    int repetition = 0;
+    std::vector<std::pair<std::string, std::string>> iterationVariables;
+
+    // Value of a global option (e.g. "sim-time-limit"), or nullptr
+    const std::string* getOption(const std::string& key) const;
+
+    // Value of a module parameter given its full path, first matching
+    // pattern wins as in OMNeT++, or nullptr
+    const std::string* getParameter(const std::string& path) const;
+
+    double getDouble(const std::string& path, double defaultValue) const;
+    long getInt(const std::string& path, long defaultValue) const;
+    bool getBool(const std::string& path, bool defaultValue) const;
+
+    // Time option in seconds, accepting the s / ms / us units
+    double getTime(const std::string& key, double defaultValue) const;
+
+    std::vector<std::pair<std::string, std::string>> entries;
+};
+
+/**
+ * Minimal reader of omnetpp.ini files: sections, extends, iteration
+ * variables (${name=v1,v2,...} and ${name} references), repeat and
+ * ${repetition}. Include files and expressions are not supported.
+ */
+class IniConfig
+{
+  public:
+    explicit IniConfig(const std::string& fileName);
+
+    bool hasConfig(const std::string& name) const { return sections.count(name) > 0; }
+
+    // All runs of a configuration, in run number order
+    std::vector<RunConfig> getRuns(const std::string& configName) const;
+
+  private:
+    typedef std::vector<std::pair<std::string, std::string>> Section;
+
+    std::vector<std::string> getSectionChain(const std::string& configName) const;
+
+    std::map<std::string, Section> sections;
+};
+
+}; // namespace
+
+#endif
@@ -0,0 +1,134 @@
+#include "PipelineModel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace project {
+
+// Mean of the SecondStage service time: uniform(0, 2*Dc) or lognormal(m, w)
+double PipelineParams::lockServiceMean() const {
+
+    if (lognormalServiceTime2)
+        return std::exp(meanServiceTime2 + stdServiceTime2 * stdServiceTime2 / 2);
+
+    return meanServiceTime2;
+}
+
+// Second moment of the SecondStage service time
+double PipelineParams::lockServiceSecondMoment() const {
+
+    if (lognormalServiceTime2)
+        return std::exp(2 * meanServiceTime2 + 2 * stdServiceTime2 * stdServiceTime2);
+
+    // uniform(0, 2*Dc): E[S^2] = (2*Dc)^2 / 3
+    return 4 * meanServiceTime2 * meanServiceTime2 / 3;
+}
+
+PipelineModel::PipelineModel(const PipelineParams& params) : params(params) {
+    runMVA(params.numThreads, throughput, lockQueue);
+}
+
+// Mean Value Analysis of the closed token sub-network for 0..maxTokens tokens
+void PipelineModel::runMVA(int maxTokens, std::vector<double>& x, std::vector<double>& q) const {
+
+    double delay = params.meanServiceTime1 + params.meanServiceTime3;
+    double lockMean = params.lockServiceMean();
+
+    // Mean residual service time seen by an arriving token (Reiser's
+    // approximation for FCFS servers with general service times)
+    double residual = lockMean > 0 ? params.lockServiceSecondMoment() / (2 * lockMean) : 0;
+
+    x.assign(maxTokens + 1, 0);
+    q.assign(maxTokens + 1, 0);
+
+    for (int k = 1; k <= maxTokens; k++) {
+        double busy = x[k - 1] * lockMean;
+        double lockResidence = lockMean + (q[k - 1] - busy) * lockMean + busy * residual;
+        x[k] = k / (delay + lockResidence);
+
+        // The approximation may overshoot for high-variance service times:
+        // enforce monotonicity and the lock capacity bound 1 / lockMean
+        x[k] = std::max(x[k], x[k - 1]);
+        if (lockMean > 0)
+            x[k] = std::min(x[k], 1 / lockMean);
+        q[k] = x[k] * lockResidence;
+    }
+}
+
+// Solves the flow-equivalent birth-death chain for the configured load
+AnalyticResult PipelineModel::solve() const {
+
+    AnalyticResult res;
+    int K = params.numThreads;
+    double lambda = params.arrivalRate();
+    double lockMean = params.lockServiceMean();
+
+    res.arrivalRate = lambda;
+    res.maxThroughput = throughput[K];
+    res.load = lambda / throughput[K];
+    res.stable = res.load < 1;
+    res.lockUtilization = std::min(1.0, lambda * lockMean);
+
+    // Saturation boundary for N and requestMeanTime
+    res.maxClients = params.requestMeanTime * throughput[K];
+    res.minRequestMeanTime = params.numClients / throughput[K];
+
+    // Smallest K: the lock alone caps the throughput to 1 / lockMean
+    if (lockMean == 0 || lambda * lockMean < 1) {
+        std::vector<double> x, q;
+        int maxTokens = std::max(K, 16);
+        for (;;) {
+            runMVA(maxTokens, x, q);
+            int k = 1;
+            while (k <= maxTokens && x[k] <= lambda)
+                k++;
+            if (k <= maxTokens) {
+                res.minThreads = k;
+                break;
+            }
+            if (maxTokens >= (1 << 20))
+                break;
+            maxTokens *= 2;
+        }
+    }
+
+    if (!res.stable) {
+        double inf = std::numeric_limits<double>::infinity();
+        res.responseTime = res.threadWaitTime = res.queueSize = inf;
+        res.threadUtilization = 1;
+        res.queueSize2 = lockQueue[K] - throughput[K] * lockMean;
+        res.lockWaitTime = res.queueSize2 / throughput[K];
+        return res;
+    }
+
+    // Unnormalized probabilities w(n) of n requests in the system, n < K,
+    // the tail n >= K is geometric with ratio r
+    double r = res.load;
+    double w = 1;
+    double sum = 0, sumN = 0, sumLock = 0;
+    for (int n = 0; n < K; n++) {
+        if (n > 0)
+            w *= lambda / throughput[n];
+        sum += w;
+        sumN += n * w;
+        sumLock += lockQueue[n] * w;
+    }
+    double wK = w * lambda / throughput[K];
+    double tail = wK / (1 - r);
+
+    sum += tail;
+    double meanBusy = (sumN + K * tail) / sum;
+    double meanQueue = wK * r / ((1 - r) * (1 - r)) / sum;
+    double meanLock = (sumLock + lockQueue[K] * tail) / sum;
+
+    res.threadUtilization = meanBusy / K;
+    res.queueSize = meanQueue;
+    res.queueSize2 = std::max(0.0, meanLock - lambda * lockMean);
+    res.responseTime = (meanBusy + meanQueue) / lambda;
+    res.threadWaitTime = meanQueue / lambda;
+    res.lockWaitTime = res.queueSize2 / lambda;
+
+    return res;
+}
+
+}; // namespace
@@ -0,0 +1,105 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef PIPELINEMODEL_H_
+#define PIPELINEMODEL_H_
+
+#include <vector>
+
+namespace project {
+
+/**
+ * Parameters of the Pipeline network, with the same meaning as the NED
+ * parameters of ClientStage, FirstStage, SecondStage and ThirdStage.
+ */
+struct PipelineParams
+{
+    int numClients = 10;              // clients.numClients (N)
+    int numThreads = 2;               // stage1.numThreads (K)
+    double requestMeanTime = 10;      // clients.requestMeanTime
+    double meanServiceTime1 = 10;     // stage1.meanServiceTime (Dp)
+    double meanServiceTime2 = 10;     // stage2.meanServiceTime (Dc, or lognormal m)
+    double stdServiceTime2 = 1;       // stage2.stdServiceTime (lognormal w)
+    bool lognormalServiceTime2 = true;// stage2.lognormalServiceTime
+    double meanServiceTime3 = 10;     // stage3.meanServiceTime
+
+    // Aggregate arrival rate of the N Poisson clients
+    double arrivalRate() const { return numClients / requestMeanTime; }
+
+    // First and second moment of the SecondStage (lock) service time
+    double lockServiceMean() const;
+    double lockServiceSecondMoment() const;
+};
+
+/**
+ * Analytical predictions for one parameter point. Times are in seconds,
+ * as in the simulation.
+ */
+struct AnalyticResult
+{
+    double arrivalRate = 0;        // lambda = N / requestMeanTime
+    double maxThroughput = 0;      // X(K): throughput with all K threads busy
+    double load = 0;               // lambda / X(K), the system is stable if < 1
+    bool stable = false;
+
+    double responseTime = 0;       // mean end-to-end response time
+    double threadWaitTime = 0;     // mean wait for a stage-1 thread
+    double lockWaitTime = 0;       // mean wait for the SecondStage lock
+    double threadUtilization = 0;  // mean fraction of busy stage-1 threads
+    double lockUtilization = 0;    // fraction of time the lock is taken
+    double queueSize = 0;          // mean stage-1 queue length
+    double queueSize2 = 0;         // mean SecondStage queue length
+
+    // Saturation boundary for the other parameters kept fixed
+    double maxClients = 0;         // largest N still stable
+    double minRequestMeanTime = 0; // smallest requestMeanTime still stable
+    int minThreads = -1;           // smallest K still stable, -1 if none
+};
+
+/**
+ * Approximate queueing model of the Pipeline network.
+ *
+ * A stage-1 thread is a token held by a request from the start of its
+ * stage-1 service until its completion at the third stage. The K tokens
+ * circulate in a closed sub-network made of a delay station (stage-1 and
+ * stage-3 service, no contention) and a single server (the SecondStage
+ * lock). Its throughput X(k) with k tokens is computed with MVA, using
+ * the residual-time correction for the non-exponential lock service.
+ * The sub-network is then replaced by a flow-equivalent server, and the
+ * whole system becomes a birth-death chain with Poisson arrivals and
+ * state-dependent service rate X(min(n, K)), solved in closed form.
+ */
+class PipelineModel
+{
+  public:
+    explicit PipelineModel(const PipelineParams& params);
+
+    AnalyticResult solve() const;
+
+    // X(k) and mean lock queue length (waiting + in service) for k = 0..K
+    const std::vector<double>& getTokenThroughput() const { return throughput; }
+    const std::vector<double>& getLockQueue() const { return lockQueue; }
+
+  private:
+    void runMVA(int maxTokens, std::vector<double>& x, std::vector<double>& q) const;
+
+    PipelineParams params;
+    std::vector<double> throughput;
+    std::vector<double> lockQueue;
+};
+
+}; // namespace
+
+#endif
@@ -0,0 +1,234 @@
+//
+// Appends finished OMNeT++ runs to a columnar result store (ResultStore.h).
+//
+// Each .sca file (and its .vec file, if present) is parsed once and stored
+// as one run: run attributes, iteration variables, config entries, scalars
+// and statistic fields (as "<name>:<field>" scalars), and vectors either
+// complete or downsampled to at most -maxpoints points per vector. Parallel
+// invocations can append to the same store, so it can be called after each
+// run of a sweep; -delete removes the text files once packed.
+//
+// Build: g++ -O2 -std=c++17 -o resultPack ResultPack.cc ResultStore.cc
+//
+// Usage: resultPack -o sweep.rst [-maxpoints <n>] [-novectors] [-delete] run.sca [run.sca ...]
+//
+
+#include "ResultStore.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace project;
+
+namespace {
+
+struct PackOptions
+{
+    std::string storeFile;
+    size_t maxPoints = 0;     // 0: keep complete vectors
+    bool vectors = true;
+    bool deleteFiles = false;
+};
+
+PackOptions opts;
+
+// Splits a result file line into tokens, honouring double quotes
+std::vector<std::string> tokenize(const std::string& line) {
+
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r'))
+            i++;
+        if (i >= line.size())
+            break;
+
+        std::string token;
+        if (line[i] == '"') {
+            for (i++; i < line.size() && line[i] != '"'; i++) {
+                if (line[i] == '\\' && i + 1 < line.size())
+                    i++;
+                token.push_back(line[i]);
+            }
+            i++;
+        }
+        else
+            while (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r')
+                token.push_back(line[i++]);
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+// Reads run attributes, scalars and statistic fields from a .sca file
+void parseScalars(const std::string& fileName, RunBuilder& run) {
+
+    std::ifstream in(fileName);
+    if (!in)
+        throw std::runtime_error("cannot open '" + fileName + "'");
+
+    std::string line, statModule, statName;
+    bool header = true;
+    while (std::getline(in, line)) {
+        std::vector<std::string> t = tokenize(line);
+        if (t.empty())
+            continue;
+
+        if (t[0] == "run" && t.size() >= 2)
+            run.addAttribute("runId", t[1]);
+        else if (t[0] == "attr" && t.size() >= 3 && header)
+            run.addAttribute(t[1], t[2]);
+        else if (t[0] == "itervar" && t.size() >= 3)
+            run.addAttribute("itervar:" + t[1], t[2]);
+        else if (t[0] == "config" && t.size() >= 3)
+            run.addAttribute("config:" + t[1], t[2]);
+        else if (t[0] == "scalar" && t.size() >= 4) {
+            header = false;
+            statName.clear();
+            run.addScalar(t[1], t[2], std::strtod(t[3].c_str(), nullptr));
+        }
+        else if (t[0] == "statistic" && t.size() >= 3) {
+            header = false;
+            statModule = t[1];
+            statName = t[2];
+        }
+        else if (t[0] == "field" && t.size() >= 3 && !statName.empty())
+            run.addScalar(statModule, statName + ":" + t[1], std::strtod(t[2].c_str(), nullptr));
+        else if (t[0] != "bin" && t[0] != "attr") {
+            header = header && t[0] != "par";
+            statName.clear();
+        }
+    }
+}
+
+// Reduces a vector to at most maxPoints points, averaging each bucket
+void downsample(std::vector<double>& times, std::vector<double>& values) {
+
+    size_t n = times.size();
+    if (opts.maxPoints == 0 || n <= opts.maxPoints)
+        return;
+
+    std::vector<double> t, v;
+    for (size_t b = 0; b < opts.maxPoints; b++) {
+        size_t from = b * n / opts.maxPoints, to = (b + 1) * n / opts.maxPoints;
+        double sum = 0;
+        for (size_t i = from; i < to; i++)
+            sum += values[i];
+        t.push_back(times[to - 1]);
+        v.push_back(sum / (to - from));
+    }
+    times.swap(t);
+    values.swap(v);
+}
+
+// Reads the vectors of a .vec file, data lines are "<id> [<event>] <time> <value>"
+void parseVectors(const std::string& fileName, RunBuilder& run) {
+
+    std::ifstream in(fileName);
+    if (!in)
+        return;
+
+    struct Vector { std::string module, name; bool hasEvent; std::vector<double> times, values; };
+    std::map<long, Vector> vectors;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty())
+            continue;
+
+        // Data lines start with the vector ID
+        if (line[0] >= '0' && line[0] <= '9') {
+            char* p;
+            long id = std::strtol(line.c_str(), &p, 10);
+            auto it = vectors.find(id);
+            if (it == vectors.end())
+                continue;
+            if (it->second.hasEvent)
+                std::strtol(p, &p, 10);
+            double time = std::strtod(p, &p);
+            double value = std::strtod(p, &p);
+            it->second.times.push_back(time);
+            it->second.values.push_back(value);
+            continue;
+        }
+
+        std::vector<std::string> t = tokenize(line);
+        if (t.size() >= 4 && t[0] == "vector") {
+            std::string columns = t.size() >= 5 ? t[4] : "TV";
+            vectors[std::atol(t[1].c_str())] = { t[2], t[3], columns.find('E') != std::string::npos, {}, {} };
+        }
+    }
+
+    for (auto& entry : vectors) {
+        Vector& vec = entry.second;
+        downsample(vec.times, vec.values);
+        run.addVector(vec.module, vec.name, vec.times, vec.values);
+    }
+}
+
+void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s -o <store> [-maxpoints <n>] [-novectors] [-delete] run.sca [run.sca ...]\n", prog);
+    std::exit(1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+    std::vector<std::string> files;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-o") && i + 1 < argc)
+            opts.storeFile = argv[++i];
+        else if (!std::strcmp(argv[i], "-maxpoints") && i + 1 < argc)
+            opts.maxPoints = std::atol(argv[++i]);
+        else if (!std::strcmp(argv[i], "-novectors"))
+            opts.vectors = false;
+        else if (!std::strcmp(argv[i], "-delete"))
+            opts.deleteFiles = true;
+        else if (argv[i][0] == '-')
+            usage(argv[0]);
+        else
+            files.push_back(argv[i]);
+    }
+    if (opts.storeFile.empty() || files.empty())
+        usage(argv[0]);
+
+    try {
+        for (const std::string& scaFile : files) {
+            RunBuilder run;
+            parseScalars(scaFile, run);
+
+            // The vector file has the same name with the .vec extension
+            std::string vecFile = scaFile;
+            if (vecFile.size() > 4 && vecFile.compare(vecFile.size() - 4, 4, ".sca") == 0)
+                vecFile.replace(vecFile.size() - 4, 4, ".vec");
+            else
+                vecFile.clear();
+            if (opts.vectors && !vecFile.empty())
+                parseVectors(vecFile, run);
+
+            appendRun(opts.storeFile, run);
+
+            if (opts.deleteFiles) {
+                std::remove(scaFile.c_str());
+                if (!vecFile.empty()) {
+                    std::remove(vecFile.c_str());
+                    std::remove((vecFile.substr(0, vecFile.size() - 4) + ".vci").c_str());
+                }
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "resultPack: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+//
+// Per-point aggregates of a result store (ResultStore.h).
+//
+// Runs are grouped into sweep points by configuration name and iteration
+// variables, the repetition excluded. For every scalar of every point it
+// prints the number of replications, mean, standard deviation and the 95%
+// confidence interval half-width, reading the memory-mapped store directly.
+//
+// Build: g++ -O2 -std=c++17 -o resultQuery ResultQuery.cc ResultStore.cc
+//
+// Usage: resultQuery [-scalar <substr>] [-module <substr>] [-list] sweep.rst
+//
+
+#include "ResultStore.h"
+#include "StudentT.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+using namespace project;
+
+namespace {
+
+struct Accumulator
+{
+    long n = 0;
+    double sum = 0;
+    double sumSq = 0;
+};
+
+// Sweep point of a run: config name plus its iteration variables
+std::string pointKey(const ResultStoreReader::Run& run) {
+
+    const char* config = run.getAttribute("configname");
+    std::string key = config ? config : "?";
+    for (size_t i = 0; i < run.getNumAttributes(); i++) {
+        const char* name = run.getAttributeKey(i);
+        if (!std::strncmp(name, "itervar:", 8) && std::strcmp(name, "itervar:repetition") != 0)
+            key += std::string(" ") + (name + 8) + "=" + run.getAttributeValue(i);
+    }
+    return key;
+}
+
+void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-scalar <substr>] [-module <substr>] [-list] <store>\n", prog);
+    std::exit(1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+    const char* scalarFilter = "";
+    const char* moduleFilter = "";
+    const char* storeFile = nullptr;
+    bool list = false;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-scalar") && i + 1 < argc)
+            scalarFilter = argv[++i];
+        else if (!std::strcmp(argv[i], "-module") && i + 1 < argc)
+            moduleFilter = argv[++i];
+        else if (!std::strcmp(argv[i], "-list"))
+            list = true;
+        else if (argv[i][0] == '-' || storeFile)
+            usage(argv[0]);
+        else
+            storeFile = argv[i];
+    }
+    if (!storeFile)
+        usage(argv[0]);
+
+    try {
+        ResultStoreReader store(storeFile);
+
+        if (list) {
+            for (size_t r = 0; r < store.getNumRuns(); r++) {
+                const ResultStoreReader::Run& run = store.getRun(r);
+                const char* runId = run.getAttribute("runId");
+                std::printf("%s  [%s]  %zu scalars, %zu vectors\n", runId ? runId : "?", pointKey(run).c_str(),
+                            run.getNumScalars(), run.getNumVectors());
+            }
+            return 0;
+        }
+
+        // Accumulate every scalar per (point, module, name)
+        std::map<std::tuple<std::string, std::string, std::string>, Accumulator> points;
+        for (size_t r = 0; r < store.getNumRuns(); r++) {
+            const ResultStoreReader::Run& run = store.getRun(r);
+            std::string key = pointKey(run);
+            for (size_t i = 0; i < run.getNumScalars(); i++) {
+                const char* name = run.getScalarName(i);
+                const char* module = run.getScalarModule(i);
+                if (!std::strstr(name, scalarFilter) || !std::strstr(module, moduleFilter))
+                    continue;
+
+                double value = run.getScalarValue(i);
+                Accumulator& acc = points[std::make_tuple(key, module, name)];
+                acc.n++;
+                acc.sum += value;
+                acc.sumSq += value * value;
+            }
+        }
+
+        std::printf("%-40s %-24s %-28s %5s %12s %12s %12s\n", "point", "module", "scalar", "n", "mean", "stddev", "ci95");
+        for (const auto& entry : points) {
+            const Accumulator& acc = entry.second;
+            double mean = acc.sum / acc.n;
+            double var = acc.n > 1 ? std::max(0.0, (acc.sumSq - acc.n * mean * mean) / (acc.n - 1)) : 0;
+            double stddev = std::sqrt(var);
+            double half = tQuantile95(acc.n - 1) * stddev / std::sqrt((double)acc.n);
+
+            std::printf("%-40s %-24s %-28s %5ld %12.6g %12.6g %12.6g\n", std::get<0>(entry.first).c_str(),
+                        std::get<1>(entry.first).c_str(), std::get<2>(entry.first).c_str(), acc.n, mean, stddev, half);
+        }
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "resultQuery: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
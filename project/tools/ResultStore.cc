@@ -0,0 +1,210 @@
+#include "ResultStore.h"
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace project {
+
+namespace {
+
+// Rounds a segment offset up to the next multiple of 8 bytes
+uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+// Reserves room for a column and returns its offset in the segment
+template<typename T>
+uint64_t layoutColumn(uint64_t& end, const std::vector<T>& column) {
+    uint64_t offset = align8(end);
+    end = offset + column.size() * sizeof(T);
+    return offset;
+}
+
+template<typename T>
+void copyColumn(std::vector<char>& segment, uint64_t offset, const std::vector<T>& column) {
+    if (!column.empty())
+        std::memcpy(segment.data() + offset, column.data(), column.size() * sizeof(T));
+}
+
+} // namespace
+
+// Returns the offset of a string in the string table, adding it if new
+uint32_t RunBuilder::intern(const std::string& str) {
+
+    auto it = stringOffsets.find(str);
+    if (it != stringOffsets.end())
+        return it->second;
+
+    uint32_t offset = strings.size();
+    strings.append(str);
+    strings.push_back('\0');
+    stringOffsets[str] = offset;
+    return offset;
+}
+
+void RunBuilder::addAttribute(const std::string& key, const std::string& value) {
+    attributeKeys.push_back(intern(key));
+    attributeValues.push_back(intern(value));
+}
+
+void RunBuilder::addScalar(const std::string& module, const std::string& name, double value) {
+    scalarModules.push_back(intern(module));
+    scalarNames.push_back(intern(name));
+    scalarValues.push_back(value);
+}
+
+void RunBuilder::addVector(const std::string& module, const std::string& name,
+                           const std::vector<double>& times, const std::vector<double>& values) {
+
+    if (times.size() != values.size())
+        throw std::invalid_argument("RunBuilder: vector times and values differ in length");
+
+    vectorModules.push_back(intern(module));
+    vectorNames.push_back(intern(name));
+    vectorFirst.push_back(pointTimes.size());
+    vectorLength.push_back(times.size());
+    pointTimes.insert(pointTimes.end(), times.begin(), times.end());
+    pointValues.insert(pointValues.end(), values.begin(), values.end());
+}
+
+// Lays out the columns after the segment header, 8-byte aligned
+std::vector<char> RunBuilder::serialize() const {
+
+    SegmentHeader h = {};
+    std::memcpy(h.magic, "RSEG", 4);
+    h.numAttributes = attributeKeys.size();
+    h.numScalars = scalarValues.size();
+    h.numVectors = vectorFirst.size();
+    h.stringBytes = strings.size();
+    h.numPoints = pointTimes.size();
+
+    uint64_t end = sizeof(SegmentHeader);
+    h.attributeKeys = layoutColumn(end, attributeKeys);
+    h.attributeValues = layoutColumn(end, attributeValues);
+    h.scalarModules = layoutColumn(end, scalarModules);
+    h.scalarNames = layoutColumn(end, scalarNames);
+    h.scalarValues = layoutColumn(end, scalarValues);
+    h.vectorModules = layoutColumn(end, vectorModules);
+    h.vectorNames = layoutColumn(end, vectorNames);
+    h.vectorFirst = layoutColumn(end, vectorFirst);
+    h.vectorLength = layoutColumn(end, vectorLength);
+    h.pointTimes = layoutColumn(end, pointTimes);
+    h.pointValues = layoutColumn(end, pointValues);
+    h.strings = align8(end);
+    h.size = align8(h.strings + strings.size());
+
+    std::vector<char> segment(h.size, 0);
+    std::memcpy(segment.data(), &h, sizeof(h));
+    copyColumn(segment, h.attributeKeys, attributeKeys);
+    copyColumn(segment, h.attributeValues, attributeValues);
+    copyColumn(segment, h.scalarModules, scalarModules);
+    copyColumn(segment, h.scalarNames, scalarNames);
+    copyColumn(segment, h.scalarValues, scalarValues);
+    copyColumn(segment, h.vectorModules, vectorModules);
+    copyColumn(segment, h.vectorNames, vectorNames);
+    copyColumn(segment, h.vectorFirst, vectorFirst);
+    copyColumn(segment, h.vectorLength, vectorLength);
+    copyColumn(segment, h.pointTimes, pointTimes);
+    copyColumn(segment, h.pointValues, pointValues);
+    std::memcpy(segment.data() + h.strings, strings.data(), strings.size());
+
+    return segment;
+}
+
+// Appends a segment under an exclusive lock, writing the file header first
+// if the store is empty
+void appendRun(const std::string& fileName, const RunBuilder& run) {
+
+    std::vector<char> segment = run.serialize();
+
+    int fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0)
+        throw std::runtime_error("cannot open result store '" + fileName + "'");
+
+    bool ok = ::flock(fd, LOCK_EX) == 0;
+    struct stat st;
+    if (ok && ::fstat(fd, &st) == 0 && st.st_size == 0) {
+        StoreFileHeader header = { {'P', 'R', 'S', 'T'}, STORE_VERSION };
+        ok = ::write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header);
+    }
+    ok = ok && ::write(fd, segment.data(), segment.size()) == (ssize_t)segment.size();
+    ::close(fd);
+
+    if (!ok)
+        throw std::runtime_error("cannot append to result store '" + fileName + "'");
+}
+
+ResultStoreReader::Run::Run(const char* segment) {
+
+    header = reinterpret_cast<const SegmentHeader*>(segment);
+    attributeKeys = reinterpret_cast<const uint32_t*>(segment + header->attributeKeys);
+    attributeValues = reinterpret_cast<const uint32_t*>(segment + header->attributeValues);
+    scalarModules = reinterpret_cast<const uint32_t*>(segment + header->scalarModules);
+    scalarNames = reinterpret_cast<const uint32_t*>(segment + header->scalarNames);
+    scalarValues = reinterpret_cast<const double*>(segment + header->scalarValues);
+    vectorModules = reinterpret_cast<const uint32_t*>(segment + header->vectorModules);
+    vectorNames = reinterpret_cast<const uint32_t*>(segment + header->vectorNames);
+    vectorFirst = reinterpret_cast<const uint64_t*>(segment + header->vectorFirst);
+    vectorLength = reinterpret_cast<const uint64_t*>(segment + header->vectorLength);
+    pointTimes = reinterpret_cast<const double*>(segment + header->pointTimes);
+    pointValues = reinterpret_cast<const double*>(segment + header->pointValues);
+    strings = segment + header->strings;
+}
+
+// Linear lookup, runs have a handful of attributes
+const char* ResultStoreReader::Run::getAttribute(const char* key) const {
+
+    for (size_t i = 0; i < getNumAttributes(); i++)
+        if (!std::strcmp(getAttributeKey(i), key))
+            return getAttributeValue(i);
+    return nullptr;
+}
+
+// Maps the whole store and indexes its segments
+ResultStoreReader::ResultStoreReader(const std::string& fileName) : data(nullptr), size(0) {
+
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open result store '" + fileName + "'");
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(StoreFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("'" + fileName + "' is not a result store");
+    }
+
+    size = st.st_size;
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        throw std::runtime_error("cannot map result store '" + fileName + "'");
+    data = static_cast<const char*>(map);
+
+    const StoreFileHeader* header = reinterpret_cast<const StoreFileHeader*>(data);
+    if (std::memcmp(header->magic, "PRST", 4) != 0 || header->version != STORE_VERSION) {
+        ::munmap(const_cast<char*>(data), size);
+        throw std::runtime_error("'" + fileName + "' is not a version 1 result store");
+    }
+
+    // Segments start 8-byte aligned since the file header is 8 bytes long
+    size_t offset = sizeof(StoreFileHeader);
+    while (offset + sizeof(SegmentHeader) <= size) {
+        const SegmentHeader* seg = reinterpret_cast<const SegmentHeader*>(data + offset);
+        if (std::memcmp(seg->magic, "RSEG", 4) != 0 || seg->size < sizeof(SegmentHeader) || offset + seg->size > size) {
+            ::munmap(const_cast<char*>(data), size);
+            throw std::runtime_error("corrupted segment in result store '" + fileName + "'");
+        }
+        runs.push_back(Run(data + offset));
+        offset += seg->size;
+    }
+}
+
+ResultStoreReader::~ResultStoreReader() {
+    ::munmap(const_cast<char*>(data), size);
+}
+
+}; // namespace
@@ -0,0 +1,167 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+
+#ifndef RESULTSTORE_H_
+#define RESULTSTORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace project {
+
+/**
+ * Columnar binary store for the results of a whole sweep.
+ *
+ * The file is a StoreFileHeader followed by one segment per run, appended
+ * under an exclusive file lock so that parallel runs can share a store.
+ * Inside a segment every field is a separate column (all module IDs, then
+ * all names, then all values, ...), 8-byte aligned, so that a reader can
+ * memory-map the file and scan a column without decoding anything.
+ * Module, name and attribute strings are stored once per segment in a
+ * string table and referenced by offset.
+ */
+struct StoreFileHeader
+{
+    char magic[4];            // "PRST"
+    uint32_t version;         // STORE_VERSION
+};
+
+struct SegmentHeader
+{
+    char magic[4];            // "RSEG"
+    uint32_t reserved;
+    uint64_t size;            // segment size in bytes, header included
+
+    uint32_t numAttributes;
+    uint32_t numScalars;
+    uint32_t numVectors;
+    uint32_t stringBytes;
+    uint64_t numPoints;
+
+    // Column offsets from the start of the segment
+    uint64_t attributeKeys;   // uint32_t[numAttributes], string offsets
+    uint64_t attributeValues; // uint32_t[numAttributes], string offsets
+    uint64_t scalarModules;   // uint32_t[numScalars], string offsets
+    uint64_t scalarNames;     // uint32_t[numScalars], string offsets
+    uint64_t scalarValues;    // double[numScalars]
+    uint64_t vectorModules;   // uint32_t[numVectors], string offsets
+    uint64_t vectorNames;     // uint32_t[numVectors], string offsets
+    uint64_t vectorFirst;     // uint64_t[numVectors], index of the first point
+    uint64_t vectorLength;    // uint64_t[numVectors], number of points
+    uint64_t pointTimes;      // double[numPoints]
+    uint64_t pointValues;     // double[numPoints]
+    uint64_t strings;         // char[stringBytes], NUL-terminated strings
+};
+
+const uint32_t STORE_VERSION = 1;
+
+/**
+ * Collects the results of one run and serializes them as a segment.
+ */
+class RunBuilder
+{
+  public:
+    void addAttribute(const std::string& key, const std::string& value);
+    void addScalar(const std::string& module, const std::string& name, double value);
+    void addVector(const std::string& module, const std::string& name,
+                   const std::vector<double>& times, const std::vector<double>& values);
+
+    std::vector<char> serialize() const;
+
+  private:
+    uint32_t intern(const std::string& str);
+
+    std::string strings;
+    std::map<std::string, uint32_t> stringOffsets;
+
+    std::vector<uint32_t> attributeKeys, attributeValues;
+    std::vector<uint32_t> scalarModules, scalarNames;
+    std::vector<double> scalarValues;
+    std::vector<uint32_t> vectorModules, vectorNames;
+    std::vector<uint64_t> vectorFirst, vectorLength;
+    std::vector<double> pointTimes, pointValues;
+};
+
+// Appends a run to the store, creating it if needed
+void appendRun(const std::string& fileName, const RunBuilder& run);
+
+/**
+ * Read-only, memory-mapped view of a result store.
+ */
+class ResultStoreReader
+{
+  public:
+    class Run
+    {
+      public:
+        size_t getNumAttributes() const { return header->numAttributes; }
+        const char* getAttributeKey(size_t i) const { return string(attributeKeys[i]); }
+        const char* getAttributeValue(size_t i) const { return string(attributeValues[i]); }
+        const char* getAttribute(const char* key) const;
+
+        size_t getNumScalars() const { return header->numScalars; }
+        const char* getScalarModule(size_t i) const { return string(scalarModules[i]); }
+        const char* getScalarName(size_t i) const { return string(scalarNames[i]); }
+        double getScalarValue(size_t i) const { return scalarValues[i]; }
+
+        size_t getNumVectors() const { return header->numVectors; }
+        const char* getVectorModule(size_t i) const { return string(vectorModules[i]); }
+        const char* getVectorName(size_t i) const { return string(vectorNames[i]); }
+        size_t getVectorLength(size_t i) const { return vectorLength[i]; }
+        const double* getVectorTimes(size_t i) const { return pointTimes + vectorFirst[i]; }
+        const double* getVectorValues(size_t i) const { return pointValues + vectorFirst[i]; }
+
+      private:
+        friend class ResultStoreReader;
+        explicit Run(const char* segment);
+        const char* string(uint32_t offset) const { return strings + offset; }
+
+        const SegmentHeader* header;
+        const uint32_t* attributeKeys;
+        const uint32_t* attributeValues;
+        const uint32_t* scalarModules;
+        const uint32_t* scalarNames;
+        const double* scalarValues;
+        const uint32_t* vectorModules;
+        const uint32_t* vectorNames;
+        const uint64_t* vectorFirst;
+        const uint64_t* vectorLength;
+        const double* pointTimes;
+        const double* pointValues;
+        const char* strings;
+    };
+
+    explicit ResultStoreReader(const std::string& fileName);
+    ~ResultStoreReader();
+
+    ResultStoreReader(const ResultStoreReader&) = delete;
+    ResultStoreReader& operator=(const ResultStoreReader&) = delete;
+
+    size_t getNumRuns() const { return runs.size(); }
+    const Run& getRun(size_t i) const { return runs[i]; }
+
+  private:
+    const char* data;
+    size_t size;
+    std::vector<Run> runs;
+};
+
+}; // namespace
+
+#endif
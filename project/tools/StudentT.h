@@ -0,0 +1,46 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+#ifndef STUDENTT_H_
+#define STUDENTT_H_
+
+namespace project {
+
+// Two-sided 95% Student t quantile for df degrees of freedom
+inline double tQuantile95(int df) {
+
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+
+    if (df < 1)
+        return 0;
+    if (df <= 30)
+        return table[df - 1];
+
+    // Cornish-Fisher expansion around the normal quantile, accurate to
+    // about 1e-4 beyond the table
+    const double z = 1.959964;
+    double z2 = z * z;
+    double n = df;
+    return z + z * (z2 + 1) / (4 * n)
+             + z * ((5 * z2 + 16) * z2 + 3) / (96 * n * n)
+             + z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / (384 * n * n * n);
+}
+
+}; // namespace
+
+#endif
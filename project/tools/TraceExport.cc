@@ -0,0 +1,161 @@
+//
+// Converts the request traces written by FirstStage (tracing = true) into
+// the Chrome trace event JSON format, which can be opened in Perfetto
+// (ui.perfetto.dev) or chrome://tracing.
+//
+// Every pool is a process and every stage-1 thread a track showing the
+// stage-1 service, lock wait, lock hold and stage-3 service of the requests
+// it served. Stage-1 queue waits are async slices, one per request, and the
+// "SecondStage lock" process shows who held the lock, so lock convoys line
+// up on a single track.
+//
+// Build: g++ -O2 -std=c++17 -o traceExport TraceExport.cc
+//
+// Usage: traceExport [-from <s>] [-to <s>] [-o out.json] file.trace [file.trace ...]
+//
+
+#include "../src/TraceRecord.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace project;
+
+namespace {
+
+FILE* out = stdout;
+bool firstEvent = true;
+
+// Writes the separator between two JSON events
+void nextEvent() {
+    std::fputs(firstEvent ? "\n" : ",\n", out);
+    firstEvent = false;
+}
+
+// Simulation seconds to trace microseconds
+double micros(double seconds) {
+    return seconds * 1e6;
+}
+
+void writeMetadata(const char* kind, int pid, int tid, const std::string& name) {
+    nextEvent();
+    std::fprintf(out, "{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                 kind, pid, tid, name.c_str());
+}
+
+// Complete event ("X") on a thread track, skipped if empty
+void writeSlice(const char* name, int pid, int tid, double from, double to, const TraceRecord& rec) {
+
+    if (to <= from)
+        return;
+
+    nextEvent();
+    std::fprintf(out, "{\"name\":\"%s\",\"cat\":\"pipeline\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                      "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"requestId\":%lld,\"clientId\":%d}}",
+                 name, pid, tid, micros(from), micros(to - from), (long long)rec.requestId, rec.clientId);
+}
+
+// Async slice ("b"/"e"), each request gets its own lane
+void writeAsync(const char* name, int pid, double from, double to, const TraceRecord& rec) {
+
+    if (to <= from)
+        return;
+
+    for (int end = 0; end < 2; end++) {
+        nextEvent();
+        std::fprintf(out, "{\"name\":\"%s\",\"cat\":\"queue\",\"ph\":\"%s\",\"id\":%lld,\"pid\":%d,\"tid\":0,"
+                          "\"ts\":%.3f,\"args\":{\"requestId\":%lld,\"clientId\":%d}}",
+                     name, end ? "e" : "b", (long long)rec.requestId, pid, micros(end ? to : from),
+                     (long long)rec.requestId, rec.clientId);
+    }
+}
+
+void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-from <s>] [-to <s>] [-o out.json] file.trace [file.trace ...]\n", prog);
+    std::exit(1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+    double from = 0, to = 1e300;
+    std::vector<const char*> files;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-from") && i + 1 < argc)
+            from = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "-to") && i + 1 < argc)
+            to = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "-o") && i + 1 < argc) {
+            out = std::fopen(argv[++i], "w");
+            if (!out) {
+                std::fprintf(stderr, "Cannot open output file '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (argv[i][0] == '-')
+            usage(argv[0]);
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty())
+        usage(argv[0]);
+
+    // Process ID 0 is the lock, pool i is process i + 1
+    const int lockPid = 0;
+    std::set<std::pair<int, int>> tracks;
+    long exported = 0;
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", out);
+    writeMetadata("process_name", lockPid, 0, "SecondStage lock");
+
+    for (const char* fileName : files) {
+        FILE* in = std::fopen(fileName, "rb");
+        if (!in) {
+            std::fprintf(stderr, "Cannot open trace file '%s'\n", fileName);
+            return 1;
+        }
+
+        TraceFileHeader header;
+        if (std::fread(&header, sizeof(header), 1, in) != 1 || std::memcmp(header.magic, "PTRC", 4) != 0
+                || header.version != TRACE_VERSION || header.recordSize != sizeof(TraceRecord)) {
+            std::fprintf(stderr, "'%s' is not a version %u trace file\n", fileName, TRACE_VERSION);
+            return 1;
+        }
+
+        int pid = header.poolId + 1;
+        writeMetadata("process_name", pid, 0, "stage1[" + std::to_string(header.poolId) + "]");
+        writeMetadata("thread_name", pid, 0, "queue");
+
+        TraceRecord rec;
+        while (std::fread(&rec, sizeof(rec), 1, in) == 1) {
+            if (rec.completion < from || rec.arrivalFirst > to)
+                continue;
+
+            if (tracks.insert({pid, rec.threadId}).second)
+                writeMetadata("thread_name", pid, rec.threadId, "thread " + std::to_string(rec.threadId));
+
+            writeAsync("stage1 queue wait", pid, rec.arrivalFirst, rec.startFirst, rec);
+            writeSlice("stage1 service", pid, rec.threadId, rec.startFirst, rec.arrivalSecond, rec);
+            writeSlice("lock wait", pid, rec.threadId, rec.arrivalSecond, rec.startSecond, rec);
+            writeSlice("lock hold", pid, rec.threadId, rec.startSecond, rec.arrivalThird, rec);
+            writeSlice("stage3 service", pid, rec.threadId, rec.arrivalThird, rec.completion, rec);
+            writeSlice("lock hold", lockPid, 0, rec.startSecond, rec.arrivalThird, rec);
+            exported++;
+        }
+        std::fclose(in);
+    }
+
+    std::fputs("\n]}\n", out);
+    if (out != stdout)
+        std::fclose(out);
+
+    std::fprintf(stderr, "Exported %ld requests\n", exported);
+    return 0;
+}